@@ -0,0 +1,676 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "mst.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+/* Command line options */
+
+typedef struct
+{
+  const char *generator;
+  size_t vertices;
+  size_t degree;
+  size_t runs;
+  unsigned long seed;
+  int max_weight;
+  const char *directory;        // where input files are written, NULL to skip
+  size_t threads;               // graph_build_parallel threads, 0 for serial
+  size_t updates;               // dynamic MST edge changes, 0 to skip
+  const char *order;            // vertex orders to compare, NULL to skip
+} bench_options;
+
+/* Random numbers */
+
+static unsigned long bench_random (unsigned long *state)
+{
+  // xorshift64*
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return (*state * 2685821657736338717UL) >> 1;
+}
+
+static int bench_weight (unsigned long *state, int max_weight)
+{
+  return (int) (bench_random (state) % (unsigned long) max_weight) + 1;
+}
+
+/* Graph generators, every generator returns a connected edge list */
+
+typedef struct
+{
+  size_t size;
+  size_t count;
+  size_t capacity;
+  graph_edge *edges;
+} edge_list;
+
+static void edge_list_add (edge_list * self, size_t source,
+                           size_t destination, int weight)
+{
+  if (self->count == self->capacity)
+    {
+      self->capacity = self->capacity < 16 ? 16 : 2 * self->capacity;
+      self->edges =
+        realloc (self->edges, self->capacity * sizeof (graph_edge));
+    }
+  self->edges[self->count].source = source;
+  self->edges[self->count].destination = destination;
+  self->edges[self->count].weight = weight;
+  ++self->count;
+}
+
+/*
+ * Random spanning tree plus random edges up to the average degree
+ */
+static void generate_sparse (edge_list * list, const bench_options * options,
+                             unsigned long *state)
+{
+  list->size = options->vertices;
+  for (size_t i = 1; i < list->size; ++i)
+    {
+      edge_list_add (list, i, bench_random (state) % i,
+                     bench_weight (state, options->max_weight));
+    }
+  size_t target = list->size * options->degree / 2;
+  while (list->count < target)
+    {
+      edge_list_add (list, bench_random (state) % list->size,
+                     bench_random (state) % list->size,
+                     bench_weight (state, options->max_weight));
+    }
+}
+
+/*
+ * Every pair of vertices with probability 1/2, with as many edges as the
+ * sparse graph of the same options
+ */
+static void generate_dense (edge_list * list, const bench_options * options,
+                            unsigned long *state)
+{
+  list->size =
+    (size_t) sqrt ((double) options->vertices * (double) options->degree *
+                   2.0);
+  if (list->size < 2)
+    {
+      list->size = 2;
+    }
+  for (size_t i = 1; i < list->size; ++i)
+    {
+      edge_list_add (list, i - 1, i,
+                     bench_weight (state, options->max_weight));
+      for (size_t j = 0; j + 1 < i; ++j)
+        {
+          if (bench_random (state) & 1)
+            {
+              edge_list_add (list, j, i,
+                             bench_weight (state, options->max_weight));
+            }
+        }
+    }
+}
+
+/*
+ * Square grid with four neighbors per vertex
+ */
+static void generate_grid (edge_list * list, const bench_options * options,
+                           unsigned long *state)
+{
+  size_t side = (size_t) sqrt ((double) options->vertices);
+  if (side < 1)
+    {
+      side = 1;
+    }
+  list->size = side * side;
+  for (size_t row = 0; row < side; ++row)
+    {
+      for (size_t column = 0; column < side; ++column)
+        {
+          size_t v = row * side + column;
+          if (column + 1 < side)
+            {
+              edge_list_add (list, v, v + 1,
+                             bench_weight (state, options->max_weight));
+            }
+          if (row + 1 < side)
+            {
+              edge_list_add (list, v, v + side,
+                             bench_weight (state, options->max_weight));
+            }
+        }
+    }
+}
+
+/*
+ * Preferential attachment, every new vertex links to degree / 2 vertices
+ * picked proportionally to their degree
+ */
+static void generate_powerlaw (edge_list * list,
+                               const bench_options * options,
+                               unsigned long *state)
+{
+  size_t links = options->degree / 2 < 1 ? 1 : options->degree / 2;
+  list->size = options->vertices;
+  for (size_t i = 1; i < list->size; ++i)
+    {
+      for (size_t j = 0; j < links; ++j)
+        {
+          // Picking an endpoint of an existing edge favors high degrees
+          size_t target = bench_random (state) % i;
+          if (list->count != 0)
+            {
+              graph_edge *edge =
+                &list->edges[bench_random (state) % list->count];
+              target = (bench_random (state) & 1)
+                ? edge->source : edge->destination;
+            }
+          if (target >= i)
+            {
+              target = bench_random (state) % i;
+            }
+          edge_list_add (list, i, target,
+                         bench_weight (state, options->max_weight));
+        }
+    }
+}
+
+/* Measurements */
+
+static double bench_now (void)
+{
+  struct timespec now;
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+static int bench_compare (const void *a, const void *b)
+{
+  double x = *(const double *) a;
+  double y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+/*
+ * Percentile of sorted samples
+ */
+static double bench_percentile (const double *samples, size_t count,
+                                double percentile)
+{
+  size_t i = (size_t) (percentile * (double) (count - 1) + 0.5);
+  return samples[i];
+}
+
+static long bench_peak_rss (void)
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+static void bench_report (const char *name, const char *phase,
+                          double *samples, size_t runs, size_t edges)
+{
+  qsort (samples, runs, sizeof (double), bench_compare);
+  double median = bench_percentile (samples, runs, 0.5);
+  printf ("%-9s %-7s %10.3f %10.3f %10.3f %12.0f\n", name, phase,
+          median * 1e3, bench_percentile (samples, runs, 0.9) * 1e3,
+          bench_percentile (samples, runs, 0.99) * 1e3,
+          median > 0 ? (double) edges / median : 0.0);
+}
+
+static double bench_file_size (const char *path)
+{
+  struct stat status;
+  return stat (path, &status) == 0 ? (double) status.st_size : 0.0;
+}
+
+/*
+ * Time loading the graph from a text edge list and from a binary CSR file
+ */
+static void bench_input (const char *name, const edge_list * list,
+                         const bench_options * options)
+{
+  char text[4096];
+  char binary[4096];
+  snprintf (text, sizeof (text), "%s/mst_bench_%s.txt", options->directory,
+            name);
+  snprintf (binary, sizeof (binary), "%s/mst_bench_%s.bin",
+            options->directory, name);
+
+  FILE *file = fopen (text, "w");
+  if (file == NULL)
+    {
+      fprintf (stderr, "cannot write %s\n", text);
+      exit (1);
+    }
+  for (size_t i = 0; i < list->count; ++i)
+    {
+      fprintf (file, "%zu %zu %d\n", list->edges[i].source,
+               list->edges[i].destination, list->edges[i].weight);
+    }
+  fclose (file);
+
+  graph g;
+  graph_create (&g);
+  graph_build (&g, list->size, list->edges, list->count);
+  int saved = graph_save (&g, binary);
+  graph_destroy (&g);
+  if (saved != 0)
+    {
+      fprintf (stderr, "cannot write %s\n", binary);
+      remove (text);
+      exit (1);
+    }
+
+  double *parse = calloc (options->runs, sizeof (double));
+  double *map = calloc (options->runs, sizeof (double));
+  for (size_t run = 0; run < options->runs; ++run)
+    {
+      double start = bench_now ();
+      graph_create (&g);
+      int loaded = graph_load_edges (&g, text);
+      double parsed = bench_now ();
+      graph_destroy (&g);
+      if (loaded != 0)
+        {
+          fprintf (stderr, "cannot load %s\n", text);
+          remove (text);
+          remove (binary);
+          exit (1);
+        }
+
+      graph_csr csr;
+      double mapped = bench_now ();
+      if (graph_csr_load (&csr, binary) == 0)
+        {
+          mst_prim_csr (&csr, 0, NULL);
+          graph_csr_destroy (&csr);
+        }
+      double done = bench_now ();
+
+      parse[run] = parsed - start;
+      map[run] = done - mapped;
+    }
+
+  double megabytes = bench_file_size (text) / 1e6;
+  qsort (parse, options->runs, sizeof (double), bench_compare);
+  printf ("# %s: text input %.1f MB, %.1f MB/s including graph_build\n",
+          name, megabytes,
+          megabytes / bench_percentile (parse, options->runs, 0.5));
+  bench_report (name, "parse", parse, options->runs, list->count);
+  bench_report (name, "mapped", map, options->runs, list->count);
+
+  remove (text);
+  remove (binary);
+  free (parse);
+  free (map);
+}
+
+/*
+ * Time edge removals and weight changes followed by the repair of the
+ * dynamic MST against rerunning mst_prim after every change
+ */
+static void bench_dynamic (const char *name, const edge_list * list,
+                           const bench_options * options)
+{
+  unsigned long state = options->seed * 40503UL + 7;
+  graph g;
+  graph_create (&g);
+  graph_build (&g, list->size, list->edges, list->count);
+  mst_prim (&g, g.vertices[0]);
+
+  mst_dynamic dynamic;
+  mst_dynamic_create (&dynamic, &g);
+  double *update = calloc (options->updates, sizeof (double));
+  double *rerun = calloc (options->updates, sizeof (double));
+  for (size_t i = 0; i < options->updates; ++i)
+    {
+      // Edges of the last tree of mst_prim are mostly in the dynamic forest
+      graph_vertex *u = g.vertices[bench_random (&state) % g.size];
+      while (u->parent == NULL)
+        {
+          u = g.vertices[bench_random (&state) % g.size];
+        }
+      graph_vertex *v = u->parent;
+      int weight = u->distance;
+      int new_weight = bench_weight (&state, options->max_weight);
+
+      double start = bench_now ();
+      if (i % 2 == 0)
+        {
+          graph_remove_edge (u, v, weight);
+          mst_dynamic_remove (&dynamic, u, v, weight);
+          graph_add_edge (u, v, new_weight);
+          mst_dynamic_insert (&dynamic, u, v, new_weight);
+        }
+      else
+        {
+          graph_set_edge_weight (u, v, weight, new_weight);
+          mst_dynamic_update (&dynamic, u, v, weight, new_weight);
+        }
+      double updated = bench_now ();
+      mst_prim (&g, g.vertices[0]);
+      double done = bench_now ();
+
+      update[i] = updated - start;
+      rerun[i] = done - updated;
+    }
+
+  bench_report (name, "update", update, options->updates, list->count);
+  bench_report (name, "rerun", rerun, options->updates, list->count);
+  free (update);
+  free (rerun);
+  mst_dynamic_destroy (&dynamic);
+  graph_destroy (&g);
+}
+
+static void bench_order_run (const char *name, const char *phase,
+                             const graph_csr * csr, double *samples,
+                             const edge_list * list,
+                             const bench_options * options)
+{
+  for (size_t run = 0; run < options->runs; ++run)
+    {
+      double start = bench_now ();
+      mst_prim_csr (csr, 0, NULL);
+      samples[run] = bench_now () - start;
+    }
+  bench_report (name, phase, samples, options->runs, list->count);
+}
+
+/*
+ * Time mst_prim_csr on the CSR graph in generator order, with shuffled
+ * vertex ids and with the shuffled graph reordered
+ */
+static void bench_order (const char *name, const edge_list * list,
+                         const bench_options * options)
+{
+  const char *names[] = { "bfs", "rcm", "degree" };
+  graph_order kinds[] = { GRAPH_ORDER_BFS, GRAPH_ORDER_RCM,
+    GRAPH_ORDER_DEGREE
+  };
+  bool all = strcmp (options->order, "all") == 0;
+  unsigned long state = options->seed * 69069UL + 5;
+
+  graph g;
+  graph_csr csr;
+  graph_csr shuffled;
+  graph_create (&g);
+  graph_build (&g, list->size, list->edges, list->count);
+  graph_csr_create (&csr, &g);
+  graph_destroy (&g);
+  size_t *order = calloc (csr.size, sizeof (size_t));
+  double *samples = calloc (options->runs, sizeof (double));
+  bench_order_run (name, "csr", &csr, samples, list, options);
+
+  for (size_t i = 0; i < csr.size; ++i)
+    {
+      order[i] = i;
+    }
+  for (size_t i = csr.size; i-- > 1;)
+    {
+      size_t j = bench_random (&state) % (i + 1);
+      size_t tmp = order[i];
+      order[i] = order[j];
+      order[j] = tmp;
+    }
+  graph_csr_permute (&shuffled, &csr, order);
+  bench_order_run (name, "shuffle", &shuffled, samples, list, options);
+
+  for (size_t k = 0; k < 3; ++k)
+    {
+      if (!all && strcmp (options->order, names[k]) != 0)
+        {
+          continue;
+        }
+      graph_csr permuted;
+      double start = bench_now ();
+      graph_csr_order (&shuffled, kinds[k], order);
+      graph_csr_permute (&permuted, &shuffled, order);
+      printf ("# %s: %s reordering %.3f ms\n", name, names[k],
+              (bench_now () - start) * 1e3);
+      bench_order_run (name, names[k], &permuted, samples, list, options);
+      graph_csr_destroy (&permuted);
+    }
+
+  free (order);
+  free (samples);
+  graph_csr_destroy (&shuffled);
+  graph_csr_destroy (&csr);
+}
+
+static void bench_generator (const char *name,
+                             void (*generate) (edge_list *,
+                                               const bench_options *,
+                                               unsigned long *),
+                             const bench_options * options)
+{
+  unsigned long state = options->seed * 2654435761UL + 1;
+  edge_list list = { 0, 0, 0, NULL };
+  generate (&list, options, &state);
+
+  double *build = calloc (options->runs, sizeof (double));
+  double *prim = calloc (options->runs, sizeof (double));
+  double *reuse = calloc (options->runs, sizeof (double));
+  double *automatic = calloc (options->runs, sizeof (double));
+  mst_workspace workspace;
+  mst_workspace_create (&workspace, list.size);
+  mst_stats stats;
+  for (size_t run = 0; run < options->runs; ++run)
+    {
+      graph g;
+      double start = bench_now ();
+      graph_create (&g);
+      if (options->threads != 0)
+        {
+          graph_build_parallel (&g, list.size, list.edges, list.count,
+                                options->threads);
+        }
+      else
+        {
+          graph_build (&g, list.size, list.edges, list.count);
+        }
+      double built = bench_now ();
+      mst_stats_reset ();
+      mst_prim (&g, g.vertices[0]);
+      double done = bench_now ();
+      if (run == 0)
+        {
+          stats = mst_stats_read ();
+        }
+      mst_prim_workspace (&g, 0, &workspace);
+      double reused = bench_now ();
+      mst_run (&g, g.vertices[0], MST_AUTO);
+      double selected = bench_now ();
+      graph_destroy (&g);
+
+      build[run] = built - start;
+      prim[run] = done - built;
+      reuse[run] = reused - done;
+      automatic[run] = selected - reused;
+    }
+  mst_workspace_destroy (&workspace);
+
+  printf ("# %s: %zu vertices, %zu edges\n", name, list.size, list.count);
+  bench_report (name, "build", build, options->runs, list.count);
+  bench_report (name, "prim", prim, options->runs, list.count);
+  bench_report (name, "reuse", reuse, options->runs, list.count);
+  bench_report (name, "auto", automatic, options->runs, list.count);
+#ifdef MST_STATS
+  printf ("# %s: %lu inserts, %lu extractions, %lu decrease keys, "
+          "%lu up and %lu down levels, %lu edges, %lu relaxations, "
+          "%.3f/%.3f/%.3f/%.3f ms init/fill/loop/cleanup\n", name,
+          (unsigned long) stats.inserts, (unsigned long) stats.extractions,
+          (unsigned long) stats.decrease_keys,
+          (unsigned long) stats.sift_up_levels,
+          (unsigned long) stats.sift_down_levels,
+          (unsigned long) stats.edges_scanned,
+          (unsigned long) stats.relaxations,
+          stats.phases[MST_PHASE_INIT] * 1e3,
+          stats.phases[MST_PHASE_FILL] * 1e3,
+          stats.phases[MST_PHASE_LOOP] * 1e3,
+          stats.phases[MST_PHASE_CLEANUP] * 1e3);
+#else
+  (void) stats;
+#endif
+  if (options->directory != NULL)
+    {
+      bench_input (name, &list, options);
+    }
+  if (options->updates != 0)
+    {
+      bench_dynamic (name, &list, options);
+    }
+  if (options->order != NULL)
+    {
+      bench_order (name, &list, options);
+    }
+
+  free (build);
+  free (prim);
+  free (reuse);
+  free (automatic);
+  free (list.edges);
+}
+
+/*
+ * Euclidean MST of uniform random points in the unit square, the edges/s
+ * column counts points
+ */
+static void bench_points (const bench_options * options)
+{
+  unsigned long state = options->seed * 2654435761UL + 3;
+  double *points = calloc (2 * options->vertices, sizeof (double));
+  for (size_t i = 0; i < 2 * options->vertices; ++i)
+    {
+      points[i] = (double) bench_random (&state) / 0x1p63;
+    }
+
+  double *euclidean = calloc (options->runs, sizeof (double));
+  for (size_t run = 0; run < options->runs; ++run)
+    {
+      double start = bench_now ();
+      mst_euclidean (points, options->vertices, 2, NULL);
+      euclidean[run] = bench_now () - start;
+    }
+
+  printf ("# points: %zu points in the unit square\n", options->vertices);
+  bench_report ("points", "kdtree", euclidean, options->runs,
+                options->vertices);
+  free (euclidean);
+  free (points);
+}
+
+static void bench_usage (const char *program)
+{
+  fprintf (stderr,
+           "usage: %s [-g sparse|dense|grid|powerlaw|points|all]\n"
+           "          [-n vertices] [-d degree] [-r runs] [-s seed]\n"
+           "          [-w max_weight]"
+           " [-i directory] [-t build_threads] [-u updates]\n"
+           "          [-o bfs|rcm|degree|all]\n",
+           program);
+}
+
+int main (int argc, const char *argv[])
+{
+  bench_options options = { "all", 100000, 8, 5, 1, 1 << 20, NULL, 0, 0, NULL };
+
+  for (int i = 1; i < argc; ++i)
+    {
+      if (i + 1 >= argc || argv[i][0] != '-' || strlen (argv[i]) != 2)
+        {
+          bench_usage (argv[0]);
+          return 1;
+        }
+      const char *value = argv[++i];
+      switch (argv[i - 1][1])
+        {
+        case 'g':
+          options.generator = value;
+          break;
+        case 'n':
+          options.vertices = strtoul (value, NULL, 10);
+          break;
+        case 'd':
+          options.degree = strtoul (value, NULL, 10);
+          break;
+        case 'r':
+          options.runs = strtoul (value, NULL, 10);
+          break;
+        case 's':
+          options.seed = strtoul (value, NULL, 10);
+          break;
+        case 'w':
+          options.max_weight = atoi (value);
+          break;
+        case 'i':
+          options.directory = value;
+          break;
+        case 't':
+          options.threads = strtoul (value, NULL, 10);
+          break;
+        case 'u':
+          options.updates = strtoul (value, NULL, 10);
+          break;
+        case 'o':
+          options.order = value;
+          break;
+        default:
+          bench_usage (argv[0]);
+          return 1;
+        }
+    }
+  if (options.vertices < 2 || options.runs < 1 || options.max_weight < 1)
+    {
+      bench_usage (argv[0]);
+      return 1;
+    }
+
+  printf ("%-9s %-7s %10s %10s %10s %12s\n", "graph", "phase", "p50 ms",
+          "p90 ms", "p99 ms", "edges/s");
+
+  bool all = strcmp (options.generator, "all") == 0;
+  bool found = false;
+  if (all || strcmp (options.generator, "sparse") == 0)
+    {
+      bench_generator ("sparse", generate_sparse, &options);
+      found = true;
+    }
+  if (all || strcmp (options.generator, "dense") == 0)
+    {
+      bench_generator ("dense", generate_dense, &options);
+      found = true;
+    }
+  if (all || strcmp (options.generator, "grid") == 0)
+    {
+      bench_generator ("grid", generate_grid, &options);
+      found = true;
+    }
+  if (all || strcmp (options.generator, "powerlaw") == 0)
+    {
+      bench_generator ("powerlaw", generate_powerlaw, &options);
+      found = true;
+    }
+  if (all || strcmp (options.generator, "points") == 0)
+    {
+      bench_points (&options);
+      found = true;
+    }
+  if (!found)
+    {
+      bench_usage (argv[0]);
+      return 1;
+    }
+
+  printf ("# peak rss: %ld KiB\n", bench_peak_rss ());
+  return 0;
+}
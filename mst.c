@@ -1,12 +1,239 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "mst.h"
 
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <values.h>
 #include <string.h>
 #include <limits.h>
+#include <math.h>
 #include <stdbool.h>
 
+/*
+ * The AVX2 relaxation kernel gathers keys with 64-bit vertex ids, it is
+ * compiled on x86-64 with GCC compatible compilers and picked at runtime
+ */
+#if defined (__x86_64__) && defined (__GNUC__) && !defined (MST_NO_SIMD)
+#define MST_SIMD_AVX2 1
+#include <immintrin.h>
+#else
+#define MST_SIMD_AVX2 0
+#endif
+
+/* Minimum degree of the vertices relaxed by the SIMD kernel */
+#ifndef MST_SIMD_DEGREE
+#define MST_SIMD_DEGREE 16
+#endif
+
+/*
+ * Number of worker threads to use when the caller asks for 0
+ */
+static size_t mst_default_threads (void)
+{
+  long online = sysconf (_SC_NPROCESSORS_ONLN);
+  return online > 0 ? (size_t) online : 1;
+}
+
+/*
+ * Run routine on each of count tasks of the given size in parallel, the
+ * calling thread runs the first one
+ */
+static void mst_parallel_run (void *(*routine) (void *), void *tasks,
+                              size_t size, size_t count)
+{
+  pthread_t *workers = calloc (count, sizeof (pthread_t));
+  for (size_t t = 1; t < count; ++t)
+    {
+      pthread_create (&workers[t], NULL, routine,
+                      (unsigned char *) tasks + t * size);
+    }
+  routine (tasks);
+  for (size_t t = 1; t < count; ++t)
+    {
+      pthread_join (workers[t], NULL);
+    }
+  free (workers);
+}
+
+/*
+ * Counters of the calling thread, the macros compile to nothing unless
+ * MST_STATS is defined
+ */
+#ifdef MST_STATS
+static __thread mst_stats mst_thread_stats;
+
+static double mst_stats_now (void)
+{
+  struct timespec now;
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+#define MST_STATS_ADD(field, count) (mst_thread_stats.field += (count))
+#define MST_STATS_START(name) double name = mst_stats_now ()
+#define MST_STATS_PHASE(phase, since) \
+  (mst_thread_stats.phases[phase] += mst_stats_now () - (since))
+#else
+#define MST_STATS_ADD(field, count) ((void) 0)
+#define MST_STATS_START(name) ((void) 0)
+#define MST_STATS_PHASE(phase, since) ((void) 0)
+#endif
+
+void mst_stats_reset (void)
+{
+#ifdef MST_STATS
+  memset (&mst_thread_stats, 0, sizeof (mst_stats));
+#endif
+}
+
+mst_stats mst_stats_read (void)
+{
+#ifdef MST_STATS
+  return mst_thread_stats;
+#else
+  mst_stats stats;
+  memset (&stats, 0, sizeof (mst_stats));
+  return stats;
+#endif
+}
+
+#define ARENA_BLOCK_SIZE (1 << 20)
+#define ARENA_ALIGNMENT 16
+
+void arena_create (arena * self, size_t block_size)
+{
+  if (self == NULL)
+    {
+      return;
+    }
+
+  self->blocks = NULL;
+  self->block_size = block_size == 0 ? ARENA_BLOCK_SIZE : block_size;
+}
+
+void arena_destroy (arena * self)
+{
+  if (self == NULL)
+    {
+      return;
+    }
+
+  while (self->blocks != NULL)
+    {
+      arena_block *next = self->blocks->next;
+      free (self->blocks);
+      self->blocks = next;
+    }
+}
+
+void *arena_alloc (arena * self, size_t size)
+{
+  if (self == NULL)
+    {
+      return NULL;
+    }
+
+  size = (size + ARENA_ALIGNMENT - 1) & ~(size_t) (ARENA_ALIGNMENT - 1);
+  arena_block *block = self->blocks;
+  if (block == NULL || block->size - block->used < size)
+    {
+      size_t block_size = size > self->block_size ? size : self->block_size;
+      block = calloc (1, sizeof (arena_block) + block_size);
+      block->size = block_size;
+      block->used = 0;
+      block->next = self->blocks;
+      self->blocks = block;
+    }
+
+  // Unused space of a block is always zeroed
+  void *ptr = block->data + block->used;
+  block->used += size;
+  return ptr;
+}
+
+void *arena_realloc (arena * self, void *ptr, size_t old_size, size_t size)
+{
+  if (self == NULL)
+    {
+      return NULL;
+    }
+  if (ptr == NULL)
+    {
+      return arena_alloc (self, size);
+    }
+  if (size <= old_size)
+    {
+      return ptr;
+    }
+
+  old_size = (old_size + ARENA_ALIGNMENT - 1) & ~(size_t) (ARENA_ALIGNMENT - 1);
+  size_t new_size =
+    (size + ARENA_ALIGNMENT - 1) & ~(size_t) (ARENA_ALIGNMENT - 1);
+  arena_block *block = self->blocks;
+  if ((unsigned char *) ptr + old_size == block->data + block->used
+      && block->used - old_size + new_size <= block->size)
+    {
+      block->used += new_size - old_size;
+      return ptr;
+    }
+
+  void *new = arena_alloc (self, size);
+  memcpy (new, ptr, old_size);
+  return new;
+}
+
+arena_mark arena_save (arena * self)
+{
+  arena_mark mark = { NULL, 0 };
+  if (self != NULL && self->blocks != NULL)
+    {
+      mark.block = self->blocks;
+      mark.used = self->blocks->used;
+    }
+  return mark;
+}
+
+void arena_restore (arena * self, arena_mark mark)
+{
+  if (self == NULL)
+    {
+      return;
+    }
+
+  while (self->blocks != NULL && self->blocks != mark.block)
+    {
+      arena_block *next = self->blocks->next;
+      free (self->blocks);
+      self->blocks = next;
+    }
+  if (self->blocks != NULL)
+    {
+      memset (self->blocks->data + mark.used, 0,
+              self->blocks->used - mark.used);
+      self->blocks->used = mark.used;
+    }
+}
+
+/*
+ * Grow an array either on the heap or in an arena
+ */
+static void *graph_realloc (arena * arena, void *ptr, size_t old_size,
+                            size_t size)
+{
+  if (arena != NULL)
+    {
+      return arena_realloc (arena, ptr, old_size, size);
+    }
+  return realloc (ptr, size);
+}
+
 void graph_create (graph * self)
 {
   if (self == NULL)
@@ -15,7 +242,36 @@ void graph_create (graph * self)
     }
 
   self->size = 0;
-  self->vertices = calloc (2, sizeof (graph_vertex));
+  self->capacity = 2;
+  self->vertices = calloc (2, sizeof (graph_vertex *));
+  self->arena = NULL;
+}
+
+void graph_create_arena (graph * self, arena * arena)
+{
+  if (self == NULL || arena == NULL)
+    {
+      return;
+    }
+
+  self->size = 0;
+  self->capacity = 2;
+  self->vertices = arena_alloc (arena, 2 * sizeof (graph_vertex *));
+  self->arena = arena;
+}
+
+static void graph_reserve (graph * self, size_t capacity)
+{
+  if (capacity <= self->capacity)
+    {
+      return;
+    }
+
+  self->vertices =
+    graph_realloc (self->arena, self->vertices,
+                   self->capacity * sizeof (graph_vertex *),
+                   capacity * sizeof (graph_vertex *));
+  self->capacity = capacity;
 }
 
 void graph_destroy_vertices (graph_vertex * vertex)
@@ -33,13 +289,18 @@ void graph_destroy (graph * self)
       return;
     }
 
-  for (size_t i = 0; i < self->size; ++i)
+  // Arena storage is released by arena_destroy
+  if (self->arena == NULL)
     {
-      graph_destroy_vertices (self->vertices[i]);
-      free (self->vertices[i]);
+      for (size_t i = 0; i < self->size; ++i)
+        {
+          graph_destroy_vertices (self->vertices[i]);
+          free (self->vertices[i]);
+        }
+      free (self->vertices);
     }
-  free (self->vertices);
   self->vertices = NULL;
+  self->capacity = 0;
 }
 
 graph_vertex *graph_add_vertex (graph * self)
@@ -49,18 +310,51 @@ graph_vertex *graph_add_vertex (graph * self)
       return NULL;
     }
 
-  graph_vertex *vertex = calloc (1, sizeof (graph_vertex));
+  graph_vertex *vertex;
+  if (self->arena != NULL)
+    {
+      vertex = arena_alloc (self->arena, sizeof (graph_vertex));
+      vertex->neighbors =
+        arena_alloc (self->arena, 2 * sizeof (graph_vertex *));
+      vertex->weights = arena_alloc (self->arena, 2 * sizeof (int));
+    }
+  else
+    {
+      vertex = calloc (1, sizeof (graph_vertex));
+      vertex->neighbors = calloc (2, sizeof (graph_vertex *));
+      vertex->weights = calloc (2, sizeof (int));
+    }
+  vertex->id = self->size;
   vertex->degree = 0;
-  vertex->neighbors = calloc (2, sizeof (graph_vertex));
-  vertex->weights = calloc (2, sizeof (int));
+  vertex->capacity = 2;
+  vertex->arena = self->arena;
 
-  self->vertices =
-    realloc (self->vertices, ++self->size * sizeof (graph_vertex *));
-  self->vertices[self->size - 1] = vertex;
+  if (self->size == self->capacity)
+    {
+      graph_reserve (self, self->capacity < 2 ? 2 : 2 * self->capacity);
+    }
+  self->vertices[self->size++] = vertex;
 
   return vertex;
 }
 
+static void graph_vertex_reserve (graph_vertex * vertex, size_t capacity)
+{
+  if (capacity <= vertex->capacity)
+    {
+      return;
+    }
+
+  vertex->neighbors =
+    graph_realloc (vertex->arena, vertex->neighbors,
+                   vertex->capacity * sizeof (graph_vertex *),
+                   capacity * sizeof (graph_vertex *));
+  vertex->weights =
+    graph_realloc (vertex->arena, vertex->weights,
+                   vertex->capacity * sizeof (int), capacity * sizeof (int));
+  vertex->capacity = capacity;
+}
+
 void graph_add_edge (graph_vertex * source, graph_vertex * destination,
                      int weight)
 {
@@ -69,244 +363,3968 @@ void graph_add_edge (graph_vertex * source, graph_vertex * destination,
       return;
     }
 
-  if (source->degree != 0)
+  if (source->degree == source->capacity)
     {
-      if (source->neighbors[source->degree - 1] != NULL)
-        {
-          graph_vertex **new =
-            calloc (2 * source->degree, sizeof (graph_vertex *));
-          memcpy (new, source->neighbors,
-                  source->degree * sizeof (graph_vertex *));
-          free (source->neighbors);
-          source->neighbors = new;
-
-          int *new_weights = calloc (2 * source->degree, sizeof (int));
-          memcpy (new_weights, source->weights,
-                  source->degree * sizeof (int));
-          free (source->weights);
-          source->weights = new_weights;
-        }
+      graph_vertex_reserve (source,
+                            source->capacity < 2 ? 2 : 2 * source->capacity);
     }
   source->neighbors[source->degree] = destination;
   source->weights[source->degree] = weight;
   source->degree++;
 
-  if (destination->degree != 0)
+  if (destination->degree == destination->capacity)
     {
-      if (destination->neighbors[destination->degree - 1] != NULL)
-        {
-          graph_vertex **new =
-            calloc (2 * destination->degree, sizeof (graph_vertex *));
-          memcpy (new, destination->neighbors,
-                  destination->degree * sizeof (graph_vertex *));
-          free (destination->neighbors);
-          destination->neighbors = new;
-
-          int *new_weights = calloc (2 * destination->degree, sizeof (int));
-          memcpy (new_weights, destination->weights,
-                  destination->degree * sizeof (int));
-          free (destination->weights);
-          destination->weights = new_weights;
-        }
+      graph_vertex_reserve (destination,
+                            destination->capacity <
+                            2 ? 2 : 2 * destination->capacity);
     }
   destination->neighbors[destination->degree] = source;
   destination->weights[destination->degree] = weight;
   destination->degree++;
 }
 
-void queue_create (queue * self)
+/*
+ * Position of an adjacency entry, GRAPH_NONE if there is none
+ */
+static size_t graph_vertex_find (const graph_vertex * vertex,
+                                 const graph_vertex * neighbor, int weight)
 {
-  if (self == NULL)
+  for (size_t i = 0; i < vertex->degree; ++i)
     {
-      return;
+      if (vertex->neighbors[i] == neighbor && vertex->weights[i] == weight)
+        {
+          return i;
+        }
     }
-  self->size = 0;
-  self->priorities = calloc (2, sizeof (int));
-  self->vertices = calloc (2, sizeof (graph_vertex));
+  return GRAPH_NONE;
 }
 
-void queue_destroy (queue * self)
+/*
+ * Remove an adjacency entry, the last entry takes its place
+ */
+static void graph_vertex_remove (graph_vertex * vertex, size_t i)
 {
-  if (self == NULL)
-    {
-      return;
-    }
-  free (self->priorities);
-  free (self->vertices);
+  vertex->degree--;
+  vertex->neighbors[i] = vertex->neighbors[vertex->degree];
+  vertex->weights[i] = vertex->weights[vertex->degree];
 }
 
-size_t queue_size (queue * self)
+int graph_remove_edge (graph_vertex * source, graph_vertex * destination,
+                       int weight)
 {
-  if (self == NULL)
+  if (source == NULL || destination == NULL)
     {
-      return 0;
+      return -1;
     }
-  return self->size;
-}
 
-void min_heapify (queue * self, size_t i)
-{
-  if (i >= self->size)
+  size_t i = graph_vertex_find (source, destination, weight);
+  if (i == GRAPH_NONE)
     {
-      return;
+      return -1;
     }
-  size_t left = 2 * i + 1;
-  size_t right = 2 * i + 2;
-  size_t min;
-
-  if (left < self->size && self->priorities[left] < self->priorities[i])
+  graph_vertex_remove (source, i);
+  i = graph_vertex_find (destination, source, weight);
+  if (i != GRAPH_NONE)
     {
-      min = left;
+      graph_vertex_remove (destination, i);
     }
-  else
+  return 0;
+}
+
+int graph_set_edge_weight (graph_vertex * source, graph_vertex * destination,
+                           int weight, int new_weight)
+{
+  if (source == NULL || destination == NULL)
     {
-      min = i;
+      return -1;
     }
-  if (right < self->size && self->priorities[right] < self->priorities[min])
+
+  size_t i = graph_vertex_find (source, destination, weight);
+  if (i == GRAPH_NONE)
     {
-      min = right;
+      return -1;
     }
-  if (min != i)
+  source->weights[i] = new_weight;
+  // A loop is listed twice in the same array, the second entry is unchanged
+  i = graph_vertex_find (destination, source, weight);
+  if (i != GRAPH_NONE)
     {
-      graph_vertex *tmp = self->vertices[i];
-      self->vertices[i] = self->vertices[min];
-      self->vertices[min] = tmp;
-
-      int temp = self->priorities[i];
-      self->priorities[i] = self->priorities[min];
-      self->priorities[min] = temp;
-
-      min_heapify (self, min);
+      destination->weights[i] = new_weight;
     }
+  return 0;
 }
 
-graph_vertex *queue_minimum (queue * self)
+/*
+ * Append size vertices without adjacency storage
+ */
+static void graph_append_vertices (graph * self, size_t size)
 {
-  if (self->size < 1)
+  graph_reserve (self, self->size + size);
+  graph_vertex *block = NULL;
+  if (self->arena != NULL)
     {
-      return NULL;
+      block = arena_alloc (self->arena, size * sizeof (graph_vertex));
     }
-  return self->vertices[0];
-}
-
-graph_vertex *queue_extract_min (queue * self)
-{
-  if (self == NULL)
+  for (size_t i = 0; i < size; ++i)
     {
-      return NULL;
+      graph_vertex *vertex =
+        block != NULL ? block + i : calloc (1, sizeof (graph_vertex));
+      vertex->id = self->size;
+      vertex->arena = self->arena;
+      self->vertices[self->size++] = vertex;
     }
-
-  graph_vertex *min = queue_minimum (self);
-  self->priorities[0] = self->priorities[self->size - 1];
-  self->vertices[0] = self->vertices[self->size - 1];
-  --self->size;
-  min_heapify (self, 0);
-  return min;
 }
 
-void queue_decrease_key (queue * self, size_t i, int key)
+void graph_build (graph * self, size_t size, const graph_edge * edges,
+                  size_t count)
 {
-  if (self == NULL)
+  if (self == NULL || (edges == NULL && count != 0))
     {
       return;
     }
 
-  if (i > self->size - 1 || key > self->priorities[i])
+  graph_append_vertices (self, size);
+
+  // First pass counts the new degree of every vertex
+  size_t *added = calloc (self->size + 1, sizeof (size_t));
+  for (size_t i = 0; i < count; ++i)
     {
-      return;
+      if (edges[i].source < self->size && edges[i].destination < self->size)
+        {
+          added[edges[i].source]++;
+          added[edges[i].destination]++;
+        }
+    }
+  for (size_t i = 0; i < self->size; ++i)
+    {
+      if (added[i] != 0)
+        {
+          graph_vertex_reserve (self->vertices[i],
+                                self->vertices[i]->degree + added[i]);
+        }
     }
+  free (added);
 
-  self->priorities[i] = key;
-  self->vertices[i]->index = (int) i;
-  while (i > 0 && self->priorities[(i - 1) / 2] > self->priorities[i])
+  // Second pass fills adjacency in the same order as graph_add_edge
+  for (size_t i = 0; i < count; ++i)
     {
-      graph_vertex *tmp = self->vertices[(i - 1) / 2];
-      self->vertices[(i - 1) / 2] = self->vertices[i];
-      self->vertices[i] = tmp;
+      if (edges[i].source < self->size && edges[i].destination < self->size)
+        {
+          graph_vertex *source = self->vertices[edges[i].source];
+          graph_vertex *destination = self->vertices[edges[i].destination];
+
+          source->neighbors[source->degree] = destination;
+          source->weights[source->degree++] = edges[i].weight;
+          destination->neighbors[destination->degree] = source;
+          destination->weights[destination->degree++] = edges[i].weight;
+        }
+    }
+}
 
-      int temp = self->priorities[(i - 1) / 2];
-      self->priorities[(i - 1) / 2] = self->priorities[i];
-      self->priorities[i] = temp;
+typedef struct
+{
+  graph *graph;
+  const graph_edge *edges;
+  size_t begin;                 // edges of this thread
+  size_t end;
+  size_t first;                 // vertices of this thread
+  size_t last;
+  size_t index;
+  size_t threads;
+  size_t **cursors;             // vertex histogram of every thread
+} graph_build_task;
 
-      self->vertices[(i - 1) / 2]->index = (int) (i - 1) / 2;
-      self->vertices[i]->index = (int) i;
+/*
+ * Count the new neighbors of every vertex in the edges of a thread
+ */
+static void *graph_build_count (void *data)
+{
+  graph_build_task *task = data;
+  size_t size = task->graph->size;
+  size_t *count = task->cursors[task->index];
 
-      i = (i - 1) / 2;
+  for (size_t i = task->begin; i < task->end; ++i)
+    {
+      if (task->edges[i].source < size && task->edges[i].destination < size)
+        {
+          count[task->edges[i].source]++;
+          count[task->edges[i].destination]++;
+        }
     }
+  return NULL;
 }
 
-void queue_insert (queue * self, graph_vertex * vertex, int key)
+/*
+ * Turn the counts of the vertices of a thread into the first slot that
+ * every thread writes to, set the final degree and grow the adjacency
+ * arrays
+ */
+static void *graph_build_offsets (void *data)
 {
-  if (self == NULL || vertex == NULL)
+  graph_build_task *task = data;
+
+  for (size_t v = task->first; v < task->last; ++v)
     {
-      return;
+      graph_vertex *vertex = task->graph->vertices[v];
+      size_t offset = vertex->degree;
+      for (size_t t = 0; t < task->threads; ++t)
+        {
+          size_t count = task->cursors[t][v];
+          task->cursors[t][v] = offset;
+          offset += count;
+        }
+      if (vertex->arena == NULL)
+        {
+          graph_vertex_reserve (vertex, offset);
+        }
+      vertex->degree = offset;
     }
+  return NULL;
+}
 
-  if (self->size != 0 && self->vertices[self->size - 1] != NULL)
-    {
-      graph_vertex **new_vertices =
-        calloc (2 * self->size, sizeof (graph_vertex *));
-      memcpy (new_vertices, self->vertices,
-              self->size * sizeof (graph_vertex *));
-      free (self->vertices);
-      self->vertices = new_vertices;
+/*
+ * Write the edges of a thread to the slots it owns
+ */
+static void *graph_build_scatter (void *data)
+{
+  graph_build_task *task = data;
+  size_t size = task->graph->size;
+  size_t *cursor = task->cursors[task->index];
 
-      int *new_priorities = calloc (2 * self->size, sizeof (int));
-      memcpy (new_priorities, self->priorities, self->size * sizeof (int));
-      free (self->priorities);
-      self->priorities = new_priorities;
+  for (size_t i = task->begin; i < task->end; ++i)
+    {
+      const graph_edge *edge = &task->edges[i];
+      if (edge->source < size && edge->destination < size)
+        {
+          graph_vertex *source = task->graph->vertices[edge->source];
+          graph_vertex *destination =
+            task->graph->vertices[edge->destination];
+          size_t slot = cursor[edge->source]++;
+          source->neighbors[slot] = destination;
+          source->weights[slot] = edge->weight;
+          slot = cursor[edge->destination]++;
+          destination->neighbors[slot] = source;
+          destination->weights[slot] = edge->weight;
+        }
     }
-
-  ++self->size;
-  self->priorities[self->size - 1] = INT_MAX;
-  self->vertices[self->size - 1] = vertex;
-  queue_decrease_key (self, self->size - 1, key);
+  return NULL;
 }
 
-int mst_prim (const graph * self, graph_vertex * source)
+void graph_build_parallel (graph * self, size_t size,
+                           const graph_edge * edges, size_t count,
+                           size_t threads)
 {
-  if (self == NULL || source == NULL)
+  if (self == NULL || (edges == NULL && count != 0))
     {
-      return 0;
+      return;
     }
-
-  for (size_t i = 0; i < self->size; ++i)
+  if (threads == 0)
     {
-      self->vertices[i]->distance = INT_MAX;
-      self->vertices[i]->parent = NULL;
+      threads = mst_default_threads ();
     }
-  source->distance = 0;
 
-  queue *q = calloc (1, sizeof (queue));
-  queue_create (q);
+  graph_append_vertices (self, size);
 
-  for (size_t i = 0; i < self->size; ++i)
+  // Every thread counts into a histogram of all the vertices, with no more
+  // threads than new neighbors per vertex the histograms and the offset
+  // pass stay within the size of the adjacency arrays
+  size_t limit = self->size == 0 ? 1 : 2 * count / self->size;
+  if (threads > limit)
     {
-      queue_insert (q, self->vertices[i], self->vertices[i]->distance);
+      threads = limit < 1 ? 1 : limit;
     }
 
-  while (queue_size (q) != 0)
+  graph_build_task *tasks = calloc (threads, sizeof (graph_build_task));
+  size_t **cursors = calloc (threads, sizeof (size_t *));
+  for (size_t t = 0; t < threads; ++t)
     {
-      graph_vertex *u = queue_extract_min (q);
-      for (size_t i = 0; i < u->degree; ++i)
+      cursors[t] = calloc (self->size + 1, sizeof (size_t));
+      tasks[t].graph = self;
+      tasks[t].edges = edges;
+      tasks[t].begin = count * t / threads;
+      tasks[t].end = count * (t + 1) / threads;
+      tasks[t].first = self->size * t / threads;
+      tasks[t].last = self->size * (t + 1) / threads;
+      tasks[t].index = t;
+      tasks[t].threads = threads;
+      tasks[t].cursors = cursors;
+    }
+
+  mst_parallel_run (graph_build_count, tasks, sizeof (graph_build_task),
+                    threads);
+  mst_parallel_run (graph_build_offsets, tasks, sizeof (graph_build_task),
+                    threads);
+
+  // The arena is not thread safe, arena vertices are grown here
+  if (self->arena != NULL)
+    {
+      for (size_t v = 0; v < self->size; ++v)
         {
-          graph_vertex *v = u->neighbors[i];
-          if (q->vertices[v->index] == v && u->weights[i] <= v->distance)
-            {
-              v->parent = u;
-              v->distance = u->weights[i];
-              queue_decrease_key (q, v->index, u->weights[i]);
-            }
+          graph_vertex_reserve (self->vertices[v],
+                                self->vertices[v]->degree);
         }
     }
 
-  int total = 0;
-  for (size_t i = 0; i < self->size; ++i)
+  mst_parallel_run (graph_build_scatter, tasks, sizeof (graph_build_task),
+                    threads);
+
+  for (size_t t = 0; t < threads; ++t)
     {
-      total += self->vertices[i]->distance;
+      free (cursors[t]);
     }
-
-  queue_destroy (q);
-  free (q);
-  return total;
+  free (cursors);
+  free (tasks);
 }
+
+#define GRAPH_LOAD_BUFFER (1 << 20)
+
+/*
+ * Largest vertex id of a text file, the queues index vertices with an int
+ */
+#define GRAPH_LOAD_MAX_ID ((long long) INT_MAX - 1)
+
+/*
+ * Vertices a text file may have beyond two per edge, ids are not remapped
+ * so sparse ids would allocate a vertex for every unused id
+ */
+#define GRAPH_LOAD_SPARSE ((size_t) 1 << 16)
+
+/*
+ * Parse an integer at *cursor, skipping blanks, return false at end of line
+ * and on numbers that are too long or not followed by a blank
+ */
+static bool graph_parse_number (const char **cursor, const char *end,
+                                long long *value)
+{
+  const char *p = *cursor;
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+    {
+      ++p;
+    }
+  bool negative = p < end && *p == '-';
+  if (negative)
+    {
+      ++p;
+    }
+  if (p == end || *p < '0' || *p > '9')
+    {
+      *cursor = p;
+      return false;
+    }
+
+  long long number = 0;
+  while (p < end && *p >= '0' && *p <= '9')
+    {
+      if (number > (LLONG_MAX - (*p - '0')) / 10)
+        {
+          *cursor = p;
+          return false;
+        }
+      number = number * 10 + (*p - '0');
+      ++p;
+    }
+  *cursor = p;
+  if (p < end && *p != ' ' && *p != '\t' && *p != '\r')
+    {
+      return false;
+    }
+  *value = negative ? -number : number;
+  return true;
+}
+
+/*
+ * Return true if only blanks are left on the line
+ */
+static bool graph_parse_end (const char *cursor, const char *end)
+{
+  while (cursor < end && (*cursor == ' ' || *cursor == '\t'
+                          || *cursor == '\r'))
+    {
+      ++cursor;
+    }
+  return cursor == end;
+}
+
+typedef struct
+{
+  graph_edge *edges;
+  size_t count;
+  size_t capacity;
+  size_t size;                  // vertices declared by a DIMACS p line
+  size_t max_id;
+  bool one_based;
+} graph_edge_reader;
+
+/*
+ * Parse one line, end points past its last character, return false if the
+ * line is malformed
+ */
+static bool graph_parse_line (graph_edge_reader * reader, const char *line,
+                              const char *end)
+{
+  while (line < end && (*line == ' ' || *line == '\t'))
+    {
+      ++line;
+    }
+  if (line == end || *line == '#' || *line == '%' || *line == 'c'
+      || *line == '\r')
+    {
+      return true;
+    }
+
+  long long u;
+  long long v;
+  long long w = 1;
+  if (*line == 'p')
+    {
+      // p <format> <vertices> <edges>
+      ++line;
+      while (line < end && (*line < '0' || *line > '9'))
+        {
+          ++line;
+        }
+      if (!graph_parse_number (&line, end, &u) || u > GRAPH_LOAD_MAX_ID + 1)
+        {
+          return false;
+        }
+      reader->size = (size_t) u;
+      reader->one_based = true;
+      return true;
+    }
+  if (*line == 'a' || *line == 'e')
+    {
+      ++line;
+    }
+  if (!graph_parse_number (&line, end, &u)
+      || !graph_parse_number (&line, end, &v))
+    {
+      return false;
+    }
+  if (!graph_parse_end (line, end)
+      && (!graph_parse_number (&line, end, &w)
+          || !graph_parse_end (line, end)))
+    {
+      return false;
+    }
+  if (reader->one_based)
+    {
+      --u;
+      --v;
+    }
+  if (u < 0 || v < 0 || u > GRAPH_LOAD_MAX_ID || v > GRAPH_LOAD_MAX_ID
+      || w < INT_MIN || w > INT_MAX)
+    {
+      return false;
+    }
+
+  if (reader->count == reader->capacity)
+    {
+      reader->capacity = reader->capacity < 1024 ? 1024 : 2 * reader->capacity;
+      reader->edges =
+        realloc (reader->edges, reader->capacity * sizeof (graph_edge));
+    }
+  graph_edge *edge = &reader->edges[reader->count++];
+  edge->source = (size_t) u;
+  edge->destination = (size_t) v;
+  edge->weight = (int) w;
+  if (edge->source > reader->max_id)
+    {
+      reader->max_id = edge->source;
+    }
+  if (edge->destination > reader->max_id)
+    {
+      reader->max_id = edge->destination;
+    }
+  return true;
+}
+
+int graph_load_edges (graph * self, const char *path)
+{
+  if (self == NULL || path == NULL)
+    {
+      return -1;
+    }
+  FILE *file = fopen (path, "rb");
+  if (file == NULL)
+    {
+      return -1;
+    }
+
+  graph_edge_reader reader = { NULL, 0, 0, 0, 0, false };
+  char *buffer = malloc (GRAPH_LOAD_BUFFER);
+  size_t pending = 0;
+  bool failed = false;
+  for (;;)
+    {
+      size_t read = fread (buffer + pending, 1, GRAPH_LOAD_BUFFER - pending,
+                           file);
+      size_t length = pending + read;
+      bool last = read == 0;
+      if (last && ferror (file))
+        {
+          failed = true;
+          break;
+        }
+
+      // Parse every complete line and keep the tail for the next chunk
+      const char *line = buffer;
+      const char *end = buffer + length;
+      const char *newline;
+      while (!failed
+             && (newline = memchr (line, '\n', (size_t) (end - line))) != NULL)
+        {
+          failed = !graph_parse_line (&reader, line, newline);
+          line = newline + 1;
+        }
+      pending = (size_t) (end - line);
+      if (failed)
+        {
+          break;
+        }
+      if (last)
+        {
+          failed = !graph_parse_line (&reader, line, end);
+          break;
+        }
+      if (pending == GRAPH_LOAD_BUFFER)
+        {
+          // A single line does not fit in the buffer
+          failed = true;
+          break;
+        }
+      memmove (buffer, line, pending);
+    }
+  fclose (file);
+  free (buffer);
+
+  if (failed)
+    {
+      free (reader.edges);
+      return -1;
+    }
+
+  size_t size = reader.count == 0 ? 0 : reader.max_id + 1;
+  if (reader.size > size)
+    {
+      size = reader.size;
+    }
+  if (size > 2 * reader.count + GRAPH_LOAD_SPARSE)
+    {
+      free (reader.edges);
+      return -1;
+    }
+  for (size_t i = 0; i < reader.count; ++i)
+    {
+      reader.edges[i].source += self->size;
+      reader.edges[i].destination += self->size;
+    }
+  graph_build (self, size, reader.edges, reader.count);
+  free (reader.edges);
+  return 0;
+}
+
+void graph_csr_create (graph_csr * self, const graph * source)
+{
+  if (self == NULL || source == NULL)
+    {
+      return;
+    }
+
+  self->size = source->size;
+  self->mapping = NULL;
+  self->mapping_size = 0;
+  self->offsets = calloc (source->size + 1, sizeof (size_t));
+  for (size_t i = 0; i < source->size; ++i)
+    {
+      self->offsets[i + 1] = self->offsets[i] + source->vertices[i]->degree;
+    }
+
+  size_t edges = self->offsets[source->size];
+  self->targets = calloc (edges + 1, sizeof (size_t));
+  self->weights = calloc (edges + 1, sizeof (int));
+  for (size_t i = 0; i < source->size; ++i)
+    {
+      graph_vertex *vertex = source->vertices[i];
+      size_t *targets = self->targets + self->offsets[i];
+      for (size_t j = 0; j < vertex->degree; ++j)
+        {
+          targets[j] = vertex->neighbors[j]->id;
+        }
+      // An isolated vertex may have no weights array at all
+      if (vertex->degree)
+        {
+          memcpy (self->weights + self->offsets[i], vertex->weights,
+                  vertex->degree * sizeof (int));
+        }
+    }
+}
+
+void graph_csr_destroy (graph_csr * self)
+{
+  if (self == NULL)
+    {
+      return;
+    }
+
+  if (self->mapping != NULL)
+    {
+      munmap (self->mapping, self->mapping_size);
+    }
+  else
+    {
+      free (self->offsets);
+      free (self->targets);
+      free (self->weights);
+    }
+  self->mapping = NULL;
+  self->mapping_size = 0;
+  self->offsets = NULL;
+  self->targets = NULL;
+  self->weights = NULL;
+  self->size = 0;
+}
+
+/*
+ * Binary CSR file: this header, then offsets, targets and weights exactly
+ * as they are laid out in memory, so that the file can be mapped as is
+ */
+typedef struct
+{
+  char magic[8];
+  uint64_t size;
+  uint64_t edges;
+  uint32_t index_bytes;
+  uint32_t weight_bytes;
+} graph_csr_header;
+
+static const char graph_csr_magic[8] = "MSTCSR1";
+
+int graph_csr_save (const graph_csr * self, const char *path)
+{
+  if (self == NULL || path == NULL)
+    {
+      return -1;
+    }
+
+  graph_csr_header header;
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, graph_csr_magic, sizeof (header.magic));
+  header.size = self->size;
+  header.edges = self->offsets[self->size];
+  header.index_bytes = sizeof (size_t);
+  header.weight_bytes = sizeof (int);
+
+  FILE *file = fopen (path, "wb");
+  if (file == NULL)
+    {
+      return -1;
+    }
+  bool written = fwrite (&header, sizeof (header), 1, file) == 1
+    && fwrite (self->offsets, sizeof (size_t), self->size + 1,
+               file) == self->size + 1
+    && fwrite (self->targets, sizeof (size_t), header.edges,
+               file) == header.edges
+    && fwrite (self->weights, sizeof (int), header.edges,
+               file) == header.edges;
+  if (fclose (file) != 0 || !written)
+    {
+      return -1;
+    }
+  return 0;
+}
+
+int graph_save (const graph * self, const char *path)
+{
+  if (self == NULL)
+    {
+      return -1;
+    }
+
+  graph_csr csr;
+  graph_csr_create (&csr, self);
+  int result = graph_csr_save (&csr, path);
+  graph_csr_destroy (&csr);
+  return result;
+}
+
+/*
+ * Return true if the offsets of a mapped CSR graph start at 0, never
+ * decrease and end at edges and every target is a vertex
+ */
+static bool graph_csr_valid (const size_t *offsets, const size_t *targets,
+                             size_t size, size_t edges)
+{
+  if (offsets[0] != 0 || offsets[size] != edges)
+    {
+      return false;
+    }
+  for (size_t v = 0; v < size; ++v)
+    {
+      if (offsets[v] > offsets[v + 1])
+        {
+          return false;
+        }
+    }
+  for (size_t i = 0; i < edges; ++i)
+    {
+      if (targets[i] >= size)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+int graph_csr_load (graph_csr * self, const char *path)
+{
+  if (self == NULL || path == NULL)
+    {
+      return -1;
+    }
+
+  int fd = open (path, O_RDONLY);
+  if (fd < 0)
+    {
+      return -1;
+    }
+  struct stat status;
+  if (fstat (fd, &status) != 0
+      || (size_t) status.st_size < sizeof (graph_csr_header))
+    {
+      close (fd);
+      return -1;
+    }
+  size_t length = (size_t) status.st_size;
+  void *mapping = mmap (NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (mapping == MAP_FAILED)
+    {
+      return -1;
+    }
+
+  const graph_csr_header *header = mapping;
+  const unsigned char *bytes = mapping;
+  size_t offsets = sizeof (graph_csr_header);
+  size_t targets = offsets + (header->size + 1) * sizeof (size_t);
+  size_t weights = targets + header->edges * sizeof (size_t);
+  if (memcmp (header->magic, graph_csr_magic, sizeof (header->magic)) != 0
+      || header->index_bytes != sizeof (size_t)
+      || header->weight_bytes != sizeof (int)
+      || header->size >= length || header->edges >= length
+      || weights + header->edges * sizeof (int) != length
+      || !graph_csr_valid ((const size_t *) (bytes + offsets),
+                           (const size_t *) (bytes + targets), header->size,
+                           header->edges))
+    {
+      munmap (mapping, length);
+      return -1;
+    }
+
+  self->size = header->size;
+  self->offsets = (size_t *) ((unsigned char *) mapping + offsets);
+  self->targets = (size_t *) ((unsigned char *) mapping + targets);
+  self->weights = (int *) ((unsigned char *) mapping + weights);
+  self->mapping = mapping;
+  self->mapping_size = length;
+  return 0;
+}
+
+
+/* Vertex reordering */
+
+typedef struct
+{
+  size_t key;
+  size_t id;
+  int weight;
+} graph_order_entry;
+
+static int graph_order_compare (const void *a, const void *b)
+{
+  const graph_order_entry *x = a;
+  const graph_order_entry *y = b;
+
+  if (x->key != y->key)
+    {
+      return x->key < y->key ? -1 : 1;
+    }
+  return (x->id > y->id) - (x->id < y->id);
+}
+
+/*
+ * Breadth-first order of every component, Cuthill-McKee starts from the
+ * vertices of smallest degree and visits neighbors by increasing degree
+ */
+static void graph_csr_order_bfs (const graph_csr * self, bool cuthill,
+                                 size_t * order)
+{
+  size_t size = self->size;
+  bool *visited = calloc (size + 1, sizeof (bool));
+  graph_order_entry *entries = calloc (size + 1, sizeof (graph_order_entry));
+  size_t *starts = calloc (size + 1, sizeof (size_t));
+
+  for (size_t i = 0; i < size; ++i)
+    {
+      entries[i].key = self->offsets[i + 1] - self->offsets[i];
+      entries[i].id = i;
+    }
+  if (cuthill)
+    {
+      qsort (entries, size, sizeof (graph_order_entry), graph_order_compare);
+    }
+  for (size_t i = 0; i < size; ++i)
+    {
+      starts[i] = entries[i].id;
+    }
+
+  size_t tail = 0;
+  for (size_t s = 0; s < size; ++s)
+    {
+      if (visited[starts[s]])
+        {
+          continue;
+        }
+      size_t head = tail;
+      order[tail++] = starts[s];
+      visited[starts[s]] = true;
+      while (head < tail)
+        {
+          size_t u = order[head++];
+          size_t first = tail;
+          for (size_t i = self->offsets[u]; i < self->offsets[u + 1]; ++i)
+            {
+              size_t v = self->targets[i];
+              if (!visited[v])
+                {
+                  visited[v] = true;
+                  order[tail++] = v;
+                }
+            }
+          if (cuthill && tail - first > 1)
+            {
+              for (size_t i = first; i < tail; ++i)
+                {
+                  entries[i - first].key =
+                    self->offsets[order[i] + 1] - self->offsets[order[i]];
+                  entries[i - first].id = order[i];
+                }
+              qsort (entries, tail - first, sizeof (graph_order_entry),
+                     graph_order_compare);
+              for (size_t i = first; i < tail; ++i)
+                {
+                  order[i] = entries[i - first].id;
+                }
+            }
+        }
+    }
+
+  if (cuthill)
+    {
+      for (size_t i = 0; i < size / 2; ++i)
+        {
+          size_t tmp = order[i];
+          order[i] = order[size - 1 - i];
+          order[size - 1 - i] = tmp;
+        }
+    }
+
+  free (visited);
+  free (entries);
+  free (starts);
+}
+
+void graph_csr_order (const graph_csr * self, graph_order kind,
+                      size_t * order)
+{
+  if (self == NULL || order == NULL)
+    {
+      return;
+    }
+
+  if (kind == GRAPH_ORDER_DEGREE)
+    {
+      graph_order_entry *entries =
+        calloc (self->size + 1, sizeof (graph_order_entry));
+      for (size_t i = 0; i < self->size; ++i)
+        {
+          // Complement of the degree so that the largest degrees come first
+          entries[i].key =
+            SIZE_MAX - (self->offsets[i + 1] - self->offsets[i]);
+          entries[i].id = i;
+        }
+      qsort (entries, self->size, sizeof (graph_order_entry),
+             graph_order_compare);
+      for (size_t i = 0; i < self->size; ++i)
+        {
+          order[i] = entries[i].id;
+        }
+      free (entries);
+      return;
+    }
+  graph_csr_order_bfs (self, kind == GRAPH_ORDER_RCM, order);
+}
+
+void graph_csr_permute (graph_csr * self, const graph_csr * source,
+                        const size_t * order)
+{
+  if (self == NULL || source == NULL || order == NULL)
+    {
+      return;
+    }
+
+  size_t size = source->size;
+  size_t *inverse = calloc (size + 1, sizeof (size_t));
+  size_t degree = 0;
+  for (size_t i = 0; i < size; ++i)
+    {
+      inverse[order[i]] = i;
+      size_t d = source->offsets[order[i] + 1] - source->offsets[order[i]];
+      degree = d > degree ? d : degree;
+    }
+
+  self->size = size;
+  self->mapping = NULL;
+  self->mapping_size = 0;
+  self->offsets = calloc (size + 1, sizeof (size_t));
+  self->targets = calloc (source->offsets[size] + 1, sizeof (size_t));
+  self->weights = calloc (source->offsets[size] + 1, sizeof (int));
+  graph_order_entry *entries = calloc (degree + 1, sizeof (graph_order_entry));
+  for (size_t i = 0; i < size; ++i)
+    {
+      size_t begin = source->offsets[order[i]];
+      size_t count = source->offsets[order[i] + 1] - begin;
+      for (size_t j = 0; j < count; ++j)
+        {
+          entries[j].key = inverse[source->targets[begin + j]];
+          entries[j].id = j;
+          entries[j].weight = source->weights[begin + j];
+        }
+      qsort (entries, count, sizeof (graph_order_entry),
+             graph_order_compare);
+
+      size_t offset = self->offsets[i];
+      for (size_t j = 0; j < count; ++j)
+        {
+          self->targets[offset + j] = entries[j].key;
+          self->weights[offset + j] = entries[j].weight;
+        }
+      self->offsets[i + 1] = offset + count;
+    }
+
+  free (entries);
+  free (inverse);
+}
+
+void graph_reorder (graph * self, const graph * source, graph_order kind,
+                    size_t * order)
+{
+  if (self == NULL || source == NULL)
+    {
+      return;
+    }
+
+  graph_csr csr;
+  graph_csr permuted;
+  size_t *ids = order;
+  if (ids == NULL)
+    {
+      ids = calloc (source->size + 1, sizeof (size_t));
+    }
+  graph_csr_create (&csr, source);
+  graph_csr_order (&csr, kind, ids);
+  graph_csr_permute (&permuted, &csr, ids);
+  graph_csr_destroy (&csr);
+
+  // Every edge once, from the endpoint listed first
+  size_t count = 0;
+  graph_edge *edges = calloc (permuted.offsets[permuted.size] / 2 + 1,
+                              sizeof (graph_edge));
+  for (size_t u = 0; u < permuted.size; ++u)
+    {
+      // A loop is listed twice in its adjacency array
+      bool loop = false;
+      for (size_t i = permuted.offsets[u]; i < permuted.offsets[u + 1]; ++i)
+        {
+          size_t v = permuted.targets[i];
+          if (v == u)
+            {
+              loop = !loop;
+            }
+          if (u < v || (v == u && loop))
+            {
+              edges[count].source = u;
+              edges[count].destination = v;
+              edges[count].weight = permuted.weights[i];
+              ++count;
+            }
+        }
+    }
+  graph_create (self);
+  graph_build (self, permuted.size, edges, count);
+
+  free (edges);
+  graph_csr_destroy (&permuted);
+  if (order == NULL)
+    {
+      free (ids);
+    }
+}
+
+void queue_create (queue * self)
+{
+  if (self == NULL)
+    {
+      return;
+    }
+  self->kind = QUEUE_HEAP;
+  self->size = 0;
+  self->capacity = 2;
+  self->arity = QUEUE_ARITY;
+  self->priorities = calloc (2, sizeof (int));
+  self->vertices = calloc (2, sizeof (graph_vertex *));
+  self->arena = NULL;
+  self->children = NULL;
+  self->siblings = NULL;
+  self->previous = NULL;
+  self->root = GRAPH_NONE;
+  self->slots = 0;
+  self->buckets = NULL;
+  self->bucket_count = 0;
+  self->cursor = 0;
+}
+
+void queue_create_dary (queue * self, size_t arity)
+{
+  if (self == NULL)
+    {
+      return;
+    }
+  queue_create (self);
+  self->arity = arity < 2 ? 2 : arity;
+}
+
+void queue_create_pairing (queue * self)
+{
+  if (self == NULL)
+    {
+      return;
+    }
+  queue_create (self);
+  self->kind = QUEUE_PAIRING;
+  self->children = calloc (2, sizeof (size_t));
+  self->siblings = calloc (2, sizeof (size_t));
+  self->previous = calloc (2, sizeof (size_t));
+}
+
+void queue_create_bucket (queue * self, int max_key)
+{
+  if (self == NULL)
+    {
+      return;
+    }
+  if (max_key < 0)
+    {
+      max_key = 0;
+    }
+  queue_create (self);
+  self->kind = QUEUE_BUCKET;
+  self->siblings = calloc (2, sizeof (size_t));
+  self->previous = calloc (2, sizeof (size_t));
+  // A first bucket for negative keys, one per key up to max_key and a last
+  // one for larger keys
+  self->bucket_count = (size_t) max_key + 3;
+  self->buckets = calloc (self->bucket_count, sizeof (size_t));
+  for (size_t i = 0; i < self->bucket_count; ++i)
+    {
+      self->buckets[i] = GRAPH_NONE;
+    }
+}
+
+void queue_create_arena (queue * self, arena * arena)
+{
+  if (self == NULL || arena == NULL)
+    {
+      return;
+    }
+  self->kind = QUEUE_HEAP;
+  self->size = 0;
+  self->capacity = 2;
+  self->arity = QUEUE_ARITY;
+  self->priorities = arena_alloc (arena, 2 * sizeof (int));
+  self->vertices = arena_alloc (arena, 2 * sizeof (graph_vertex *));
+  self->arena = arena;
+  self->children = NULL;
+  self->siblings = NULL;
+  self->previous = NULL;
+  self->root = GRAPH_NONE;
+  self->slots = 0;
+  self->buckets = NULL;
+  self->bucket_count = 0;
+  self->cursor = 0;
+}
+
+void queue_destroy (queue * self)
+{
+  if (self == NULL)
+    {
+      return;
+    }
+  if (self->arena == NULL)
+    {
+      free (self->priorities);
+      free (self->vertices);
+      free (self->children);
+      free (self->siblings);
+      free (self->previous);
+      free (self->buckets);
+    }
+  self->priorities = NULL;
+  self->vertices = NULL;
+  self->children = NULL;
+  self->siblings = NULL;
+  self->previous = NULL;
+  self->buckets = NULL;
+}
+
+size_t queue_size (queue * self)
+{
+  if (self == NULL)
+    {
+      return 0;
+    }
+  return self->size;
+}
+
+/*
+ * Make sure there is room for one more slot
+ */
+static void queue_grow (queue * self, size_t used)
+{
+  if (used < self->capacity)
+    {
+      return;
+    }
+
+  size_t capacity = self->capacity < 2 ? 2 : 2 * self->capacity;
+  self->vertices =
+    graph_realloc (self->arena, self->vertices,
+                   self->capacity * sizeof (graph_vertex *),
+                   capacity * sizeof (graph_vertex *));
+  self->priorities =
+    graph_realloc (self->arena, self->priorities,
+                   self->capacity * sizeof (int), capacity * sizeof (int));
+  if (self->kind == QUEUE_PAIRING)
+    {
+      self->children =
+        graph_realloc (self->arena, self->children,
+                       self->capacity * sizeof (size_t),
+                       capacity * sizeof (size_t));
+    }
+  if (self->kind != QUEUE_HEAP)
+    {
+      self->siblings =
+        graph_realloc (self->arena, self->siblings,
+                       self->capacity * sizeof (size_t),
+                       capacity * sizeof (size_t));
+      self->previous =
+        graph_realloc (self->arena, self->previous,
+                       self->capacity * sizeof (size_t),
+                       capacity * sizeof (size_t));
+    }
+  self->capacity = capacity;
+}
+
+void min_heapify (queue * self, size_t i)
+{
+  if (i >= self->size)
+    {
+      return;
+    }
+
+  // Move the hole down instead of swapping at every level
+  graph_vertex *vertex = self->vertices[i];
+  int priority = self->priorities[i];
+  for (;;)
+    {
+      size_t first = self->arity * i + 1;
+      if (first >= self->size)
+        {
+          break;
+        }
+      size_t last = first + self->arity;
+      if (last > self->size)
+        {
+          last = self->size;
+        }
+
+      size_t min = first;
+      for (size_t child = first + 1; child < last; ++child)
+        {
+          if (self->priorities[child] < self->priorities[min])
+            {
+              min = child;
+            }
+        }
+      if (self->priorities[min] >= priority)
+        {
+          break;
+        }
+
+      self->vertices[i] = self->vertices[min];
+      self->priorities[i] = self->priorities[min];
+      self->vertices[i]->index = (int) i;
+      i = min;
+      MST_STATS_ADD (sift_down_levels, 1);
+    }
+  self->vertices[i] = vertex;
+  self->priorities[i] = priority;
+  vertex->index = (int) i;
+}
+
+/*
+ * Pairing heap: nodes are slots of the vertices and priorities arrays, a
+ * node links to its first child, its next sibling and to its previous
+ * sibling or its parent when it is a first child
+ */
+static size_t pairing_link (queue * self, size_t a, size_t b)
+{
+  if (self->priorities[b] < self->priorities[a])
+    {
+      size_t tmp = a;
+      a = b;
+      b = tmp;
+    }
+
+  self->siblings[b] = self->children[a];
+  if (self->children[a] != GRAPH_NONE)
+    {
+      self->previous[self->children[a]] = b;
+    }
+  self->children[a] = b;
+  self->previous[b] = a;
+  return a;
+}
+
+static void pairing_cut (queue * self, size_t i)
+{
+  size_t previous = self->previous[i];
+  if (self->children[previous] == i)
+    {
+      self->children[previous] = self->siblings[i];
+    }
+  else
+    {
+      self->siblings[previous] = self->siblings[i];
+    }
+  if (self->siblings[i] != GRAPH_NONE)
+    {
+      self->previous[self->siblings[i]] = previous;
+    }
+  self->siblings[i] = GRAPH_NONE;
+  self->previous[i] = GRAPH_NONE;
+}
+
+static graph_vertex *pairing_extract_min (queue * self)
+{
+  size_t min = self->root;
+  graph_vertex *vertex = self->vertices[min];
+
+  // Merge children pairwise from left to right, the results are stacked
+  size_t stack = GRAPH_NONE;
+  size_t first = self->children[min];
+  while (first != GRAPH_NONE)
+    {
+      size_t second = self->siblings[first];
+      size_t next = second == GRAPH_NONE ? GRAPH_NONE : self->siblings[second];
+      self->siblings[first] = GRAPH_NONE;
+      self->previous[first] = GRAPH_NONE;
+      size_t merged = first;
+      if (second != GRAPH_NONE)
+        {
+          self->siblings[second] = GRAPH_NONE;
+          self->previous[second] = GRAPH_NONE;
+          merged = pairing_link (self, first, second);
+        }
+      self->siblings[merged] = stack;
+      stack = merged;
+      first = next;
+    }
+
+  // Then merge the stacked pairs from right to left
+  self->root = stack;
+  if (stack != GRAPH_NONE)
+    {
+      stack = self->siblings[stack];
+      self->siblings[self->root] = GRAPH_NONE;
+      while (stack != GRAPH_NONE)
+        {
+          size_t next = self->siblings[stack];
+          self->siblings[stack] = GRAPH_NONE;
+          self->root = pairing_link (self, self->root, stack);
+          stack = next;
+        }
+      self->previous[self->root] = GRAPH_NONE;
+    }
+
+  self->vertices[min] = NULL;
+  --self->size;
+  if (self->size == 0)
+    {
+      self->slots = 0;
+    }
+  return vertex;
+}
+
+/*
+ * Bucket queue: slots with the same key are in a doubly linked list through
+ * siblings and previous, cursor is at or below the first non-empty bucket,
+ * key k is in bucket k + 1 and the first and last buckets mix keys
+ */
+static size_t bucket_of (queue * self, int key)
+{
+  if (key < 0)
+    {
+      return 0;
+    }
+  if ((size_t) key >= self->bucket_count - 2)
+    {
+      return self->bucket_count - 1;
+    }
+  return (size_t) key + 1;
+}
+
+static void bucket_push (queue * self, size_t slot)
+{
+  size_t bucket = bucket_of (self, self->priorities[slot]);
+  self->previous[slot] = GRAPH_NONE;
+  self->siblings[slot] = self->buckets[bucket];
+  if (self->buckets[bucket] != GRAPH_NONE)
+    {
+      self->previous[self->buckets[bucket]] = slot;
+    }
+  self->buckets[bucket] = slot;
+  if (bucket < self->cursor)
+    {
+      self->cursor = bucket;
+    }
+}
+
+static void bucket_remove (queue * self, size_t slot)
+{
+  size_t bucket = bucket_of (self, self->priorities[slot]);
+  if (self->previous[slot] == GRAPH_NONE)
+    {
+      self->buckets[bucket] = self->siblings[slot];
+    }
+  else
+    {
+      self->siblings[self->previous[slot]] = self->siblings[slot];
+    }
+  if (self->siblings[slot] != GRAPH_NONE)
+    {
+      self->previous[self->siblings[slot]] = self->previous[slot];
+    }
+}
+
+static graph_vertex *bucket_extract_min (queue * self)
+{
+  while (self->buckets[self->cursor] == GRAPH_NONE)
+    {
+      ++self->cursor;
+    }
+
+  // Only the first and last buckets mix keys and need a scan
+  size_t min = self->buckets[self->cursor];
+  if (self->cursor == 0 || self->cursor == self->bucket_count - 1)
+    {
+      for (size_t i = self->siblings[min]; i != GRAPH_NONE;
+           i = self->siblings[i])
+        {
+          if (self->priorities[i] < self->priorities[min])
+            {
+              min = i;
+            }
+        }
+    }
+
+  graph_vertex *vertex = self->vertices[min];
+  bucket_remove (self, min);
+  self->vertices[min] = NULL;
+  --self->size;
+  if (self->size == 0)
+    {
+      self->slots = 0;
+    }
+  return vertex;
+}
+
+int queue_contains (queue * self, const graph_vertex * vertex)
+{
+  if (self == NULL || vertex == NULL || vertex->index < 0)
+    {
+      return 0;
+    }
+  size_t used = self->kind == QUEUE_HEAP ? self->size : self->slots;
+  return (size_t) vertex->index < used
+    && self->vertices[vertex->index] == vertex;
+}
+
+graph_vertex *queue_minimum (queue * self)
+{
+  if (self->size < 1)
+    {
+      return NULL;
+    }
+  return self->vertices[self->kind == QUEUE_HEAP ? 0 : self->root];
+}
+
+graph_vertex *queue_extract_min (queue * self)
+{
+  if (self == NULL || self->size == 0)
+    {
+      return NULL;
+    }
+  MST_STATS_ADD (extractions, 1);
+  if (self->kind == QUEUE_PAIRING)
+    {
+      return pairing_extract_min (self);
+    }
+  if (self->kind == QUEUE_BUCKET)
+    {
+      return bucket_extract_min (self);
+    }
+
+  graph_vertex *min = queue_minimum (self);
+  self->priorities[0] = self->priorities[self->size - 1];
+  self->vertices[0] = self->vertices[self->size - 1];
+  --self->size;
+  min_heapify (self, 0);
+  return min;
+}
+
+/*
+ * Move the vertex of heap slot i up to its place for a smaller key
+ */
+static void queue_sift_up (queue * self, size_t i, int key)
+{
+  graph_vertex *vertex = self->vertices[i];
+  while (i > 0 && self->priorities[(i - 1) / self->arity] > key)
+    {
+      size_t parent = (i - 1) / self->arity;
+      self->vertices[i] = self->vertices[parent];
+      self->priorities[i] = self->priorities[parent];
+      self->vertices[i]->index = (int) i;
+      i = parent;
+      MST_STATS_ADD (sift_up_levels, 1);
+    }
+  self->vertices[i] = vertex;
+  self->priorities[i] = key;
+  vertex->index = (int) i;
+}
+
+void queue_decrease_key (queue * self, size_t i, int key)
+{
+  if (self == NULL)
+    {
+      return;
+    }
+  size_t used = self->kind == QUEUE_HEAP ? self->size : self->slots;
+  if (i >= used || self->vertices[i] == NULL || key >= self->priorities[i])
+    {
+      return;
+    }
+  MST_STATS_ADD (decrease_keys, 1);
+
+  if (self->kind == QUEUE_BUCKET)
+    {
+      bucket_remove (self, i);
+      self->priorities[i] = key;
+      bucket_push (self, i);
+      return;
+    }
+  if (self->kind == QUEUE_PAIRING)
+    {
+      self->priorities[i] = key;
+      if (i != self->root)
+        {
+          pairing_cut (self, i);
+          self->root = pairing_link (self, self->root, i);
+        }
+      return;
+    }
+  queue_sift_up (self, i, key);
+}
+
+void queue_insert (queue * self, graph_vertex * vertex, int key)
+{
+  if (self == NULL || vertex == NULL)
+    {
+      return;
+    }
+  MST_STATS_ADD (inserts, 1);
+
+  if (self->kind == QUEUE_PAIRING)
+    {
+      queue_grow (self, self->slots);
+      size_t slot = self->slots++;
+      self->vertices[slot] = vertex;
+      self->priorities[slot] = key;
+      self->children[slot] = GRAPH_NONE;
+      self->siblings[slot] = GRAPH_NONE;
+      self->previous[slot] = GRAPH_NONE;
+      vertex->index = (int) slot;
+      self->root =
+        self->size == 0 ? slot : pairing_link (self, self->root, slot);
+      ++self->size;
+      return;
+    }
+  if (self->kind == QUEUE_BUCKET)
+    {
+      queue_grow (self, self->slots);
+      size_t slot = self->slots++;
+      self->vertices[slot] = vertex;
+      self->priorities[slot] = key;
+      vertex->index = (int) slot;
+      bucket_push (self, slot);
+      ++self->size;
+      return;
+    }
+
+  queue_grow (self, self->size);
+  ++self->size;
+  self->priorities[self->size - 1] = key;
+  self->vertices[self->size - 1] = vertex;
+  queue_sift_up (self, self->size - 1, key);
+}
+
+/*
+ * Mark every vertex as undiscovered, vertices enter the queue when they are
+ * discovered and index is -1 before
+ */
+static void mst_prim_reset (const graph * self)
+{
+  for (size_t i = 0; i < self->size; ++i)
+    {
+      self->vertices[i]->distance = INT_MAX;
+      self->vertices[i]->index = -1;
+      self->vertices[i]->parent = NULL;
+    }
+}
+
+/*
+ * Grow a tree from an undiscovered root and return its weight
+ */
+static int64_t mst_prim_grow (graph_vertex * root, queue * q)
+{
+  int64_t total = 0;
+
+  MST_STATS_START (fill);
+  root->distance = 0;
+  queue_insert (q, root, 0);
+  MST_STATS_PHASE (MST_PHASE_FILL, fill);
+
+  MST_STATS_START (loop);
+  while (queue_size (q) != 0)
+    {
+      graph_vertex *u = queue_extract_min (q);
+      total += u->distance;
+      MST_STATS_ADD (edges_scanned, u->degree);
+      for (size_t i = 0; i < u->degree; ++i)
+        {
+          graph_vertex *v = u->neighbors[i];
+          if (v->index == -1)
+            {
+              v->parent = u;
+              v->distance = u->weights[i];
+              queue_insert (q, v, u->weights[i]);
+              MST_STATS_ADD (relaxations, 1);
+            }
+          else if (u->weights[i] <= v->distance && queue_contains (q, v))
+            {
+              v->parent = u;
+              v->distance = u->weights[i];
+              queue_decrease_key (q, v->index, u->weights[i]);
+              MST_STATS_ADD (relaxations, 1);
+            }
+        }
+    }
+  MST_STATS_PHASE (MST_PHASE_LOOP, loop);
+  return total;
+}
+
+int64_t mst_prim_queue (const graph * self, graph_vertex * source, queue * q)
+{
+  if (self == NULL || source == NULL || q == NULL)
+    {
+      return 0;
+    }
+
+  MST_STATS_START (init);
+  mst_prim_reset (self);
+  MST_STATS_PHASE (MST_PHASE_INIT, init);
+  return mst_prim_grow (source, q);
+}
+
+/*
+ * Create the queue used by the graph algorithms, in the graph arena when
+ * there is one
+ */
+static queue *mst_queue_create (const graph * self, arena_mark * mark)
+{
+  queue *q;
+  *mark = arena_save (self->arena);
+  if (self->arena != NULL)
+    {
+      q = arena_alloc (self->arena, sizeof (queue));
+      queue_create_arena (q, self->arena);
+    }
+  else
+    {
+      q = calloc (1, sizeof (queue));
+      queue_create (q);
+    }
+  return q;
+}
+
+static void mst_queue_destroy (const graph * self, queue * q, arena_mark mark)
+{
+  queue_destroy (q);
+  if (self->arena != NULL)
+    {
+      arena_restore (self->arena, mark);
+    }
+  else
+    {
+      free (q);
+    }
+}
+
+int64_t mst_prim (const graph * self, graph_vertex * source)
+{
+  if (self == NULL || source == NULL)
+    {
+      return 0;
+    }
+
+  MST_STATS_START (init);
+  arena_mark mark;
+  queue *q = mst_queue_create (self, &mark);
+  MST_STATS_PHASE (MST_PHASE_INIT, init);
+  int64_t total = mst_prim_queue (self, source, q);
+  MST_STATS_START (cleanup);
+  mst_queue_destroy (self, q, mark);
+  MST_STATS_PHASE (MST_PHASE_CLEANUP, cleanup);
+  return total;
+}
+
+void mst_forest_create (mst_forest * self)
+{
+  if (self == NULL)
+    {
+      return;
+    }
+  self->count = 0;
+  self->capacity = 0;
+  self->roots = NULL;
+  self->weights = NULL;
+  self->total = 0;
+}
+
+void mst_forest_destroy (mst_forest * self)
+{
+  if (self == NULL)
+    {
+      return;
+    }
+  free (self->roots);
+  free (self->weights);
+  self->roots = NULL;
+  self->weights = NULL;
+  self->count = 0;
+  self->capacity = 0;
+}
+
+int64_t mst_prim_forest (const graph * self, mst_forest * forest)
+{
+  if (self == NULL || forest == NULL)
+    {
+      return 0;
+    }
+
+  forest->count = 0;
+  forest->total = 0;
+  arena_mark mark;
+  queue *q = mst_queue_create (self, &mark);
+  mst_prim_reset (self);
+  for (size_t i = 0; i < self->size; ++i)
+    {
+      graph_vertex *root = self->vertices[i];
+      if (root->index != -1)
+        {
+          continue;
+        }
+
+      if (forest->count == forest->capacity)
+        {
+          forest->capacity = forest->capacity < 2 ? 2 : 2 * forest->capacity;
+          forest->roots =
+            realloc (forest->roots,
+                     forest->capacity * sizeof (graph_vertex *));
+          forest->weights =
+            realloc (forest->weights, forest->capacity * sizeof (int64_t));
+        }
+      int64_t weight = mst_prim_grow (root, q);
+      forest->roots[forest->count] = root;
+      forest->weights[forest->count] = weight;
+      forest->count++;
+      forest->total += weight;
+    }
+  mst_queue_destroy (self, q, mark);
+  return forest->total;
+}
+
+
+/* Indexed binary heap of vertex ids, used by the CSR algorithms */
+
+// Generated by mst_weight.h like the heaps of the typed CSR graphs
+#define WEIGHT_HEAP id_heap
+#define WEIGHT_TYPE int
+#include "mst_weight.h"
+
+void mst_workspace_create (mst_workspace * self, size_t size)
+{
+  if (self == NULL)
+    {
+      return;
+    }
+
+  self->capacity = size;
+  self->vertices = calloc (size + 1, sizeof (size_t));
+  self->priorities = calloc (size + 1, sizeof (int));
+  self->positions = calloc (size + 1, sizeof (size_t));
+  self->keys = calloc (size + 1, sizeof (int));
+  self->parents = calloc (size + 1, sizeof (size_t));
+}
+
+void mst_workspace_destroy (mst_workspace * self)
+{
+  if (self == NULL)
+    {
+      return;
+    }
+
+  free (self->vertices);
+  free (self->priorities);
+  free (self->positions);
+  free (self->keys);
+  free (self->parents);
+  self->vertices = NULL;
+  self->priorities = NULL;
+  self->positions = NULL;
+  self->keys = NULL;
+  self->parents = NULL;
+  self->capacity = 0;
+}
+
+/*
+ * Grow a workspace to size vertices if needed, reset it and return a heap
+ * holding only the source
+ */
+static id_heap mst_workspace_start (mst_workspace * self, size_t size,
+                                    size_t source)
+{
+  if (size > self->capacity)
+    {
+      mst_workspace_destroy (self);
+      mst_workspace_create (self, size);
+    }
+
+  id_heap heap;
+  heap.size = 0;
+  heap.vertices = self->vertices;
+  heap.priorities = self->priorities;
+  heap.positions = self->positions;
+  heap.keys = self->keys;
+  for (size_t i = 0; i < size; ++i)
+    {
+      heap.keys[i] = INT_MAX;
+      heap.positions[i] = GRAPH_NONE;
+      self->parents[i] = GRAPH_NONE;
+    }
+  heap.keys[source] = 0;
+  id_heap_update (&heap, source);
+  return heap;
+}
+
+int64_t mst_prim_workspace (const graph * self, size_t source,
+                            mst_workspace * workspace)
+{
+  return mst_prim_filter (self, source, workspace, NULL, NULL);
+}
+
+int64_t mst_prim_filter (const graph * self, size_t source,
+                         mst_workspace * workspace, mst_edge_filter filter,
+                         void *data)
+{
+  if (self == NULL || workspace == NULL || source >= self->size)
+    {
+      return 0;
+    }
+
+  id_heap heap = mst_workspace_start (workspace, self->size, source);
+  size_t *parents = workspace->parents;
+
+  // Extracted vertices get INT_MIN as key so that they are never relaxed
+  int64_t total = 0;
+  while (heap.size != 0)
+    {
+      size_t u = id_heap_pop (&heap);
+      total += heap.keys[u];
+      heap.keys[u] = INT_MIN;
+
+      // Local copies, stores to parents could alias the vertex fields
+      const graph_vertex *vertex = self->vertices[u];
+      graph_vertex *const *neighbors = vertex->neighbors;
+      const int *weights = vertex->weights;
+      size_t degree = vertex->degree;
+      for (size_t i = 0; i < degree; ++i)
+        {
+          size_t v = neighbors[i]->id;
+          int weight = weights[i];
+          if (weight <= heap.keys[v] && heap.keys[v] != INT_MIN
+              && (filter == NULL || filter (u, v, weight, data)))
+            {
+              parents[v] = u;
+              heap.keys[v] = weight;
+              id_heap_update (&heap, v);
+            }
+        }
+    }
+  return total;
+}
+
+/*
+ * Relax the edges [begin, end) of the CSR arrays leaving u
+ */
+typedef void (*mst_relax_kernel) (id_heap * heap, size_t * parents, size_t u,
+                                  const size_t * targets, const int *weights,
+                                  size_t begin, size_t end);
+
+#if MST_SIMD_AVX2
+/*
+ * Compare blocks of 8 weights with the gathered keys of their targets and
+ * only visit the candidates, which are checked again since a block may
+ * hold the same target twice
+ */
+__attribute__ ((target ("avx2")))
+static void mst_relax_avx2 (id_heap * heap, size_t * parents, size_t u,
+                            const size_t * targets, const int *weights,
+                            size_t begin, size_t end)
+{
+  const __m256i done = _mm256_set1_epi32 (INT_MIN);
+  size_t i = begin;
+  for (; i < end; i += 8)
+    {
+      unsigned mask = (1u << (end - i < 8 ? end - i : 8)) - 1;
+      if (end - i >= 8)
+        {
+          __m256i low = _mm256_loadu_si256 ((const __m256i *) (targets + i));
+          __m256i high =
+            _mm256_loadu_si256 ((const __m256i *) (targets + i + 4));
+          __m256i keys =
+            _mm256_set_m128i (_mm256_i64gather_epi32 (heap->keys, high, 4),
+                              _mm256_i64gather_epi32 (heap->keys, low, 4));
+          __m256i block =
+            _mm256_loadu_si256 ((const __m256i *) (weights + i));
+          __m256i rejected =
+            _mm256_or_si256 (_mm256_cmpgt_epi32 (block, keys),
+                             _mm256_cmpeq_epi32 (keys, done));
+          mask &= ~(unsigned)
+            _mm256_movemask_ps (_mm256_castsi256_ps (rejected));
+        }
+      while (mask != 0)
+        {
+          size_t j = i + (size_t) __builtin_ctz (mask);
+          mask &= mask - 1;
+          size_t v = targets[j];
+          if (weights[j] <= heap->keys[v] && heap->keys[v] != INT_MIN)
+            {
+              parents[v] = u;
+              heap->keys[v] = weights[j];
+              id_heap_update (heap, v);
+            }
+        }
+    }
+}
+#endif
+
+/*
+ * Vectorized relaxation kernel for the running processor, NULL when there
+ * is none
+ */
+static mst_relax_kernel mst_relax_select (void)
+{
+#if MST_SIMD_AVX2
+  if (__builtin_cpu_supports ("avx2"))
+    {
+      return mst_relax_avx2;
+    }
+#endif
+  return NULL;
+}
+
+int64_t mst_prim_csr_workspace (const graph_csr * self, size_t source,
+                                mst_workspace * workspace)
+{
+  if (self == NULL || workspace == NULL || source >= self->size)
+    {
+      return 0;
+    }
+
+  id_heap heap = mst_workspace_start (workspace, self->size, source);
+  size_t *parents = workspace->parents;
+  mst_relax_kernel relax = mst_relax_select ();
+
+  int64_t total = 0;
+  while (heap.size != 0)
+    {
+      size_t u = id_heap_pop (&heap);
+      total += heap.keys[u];
+      heap.keys[u] = INT_MIN;
+
+      size_t begin = self->offsets[u];
+      size_t end = self->offsets[u + 1];
+      if (relax != NULL && end - begin >= MST_SIMD_DEGREE)
+        {
+          relax (&heap, parents, u, self->targets, self->weights, begin,
+                 end);
+          continue;
+        }
+      for (size_t i = begin; i < end; ++i)
+        {
+          size_t v = self->targets[i];
+          int weight = self->weights[i];
+          if (weight <= heap.keys[v] && heap.keys[v] != INT_MIN)
+            {
+              parents[v] = u;
+              heap.keys[v] = weight;
+              id_heap_update (&heap, v);
+            }
+        }
+    }
+  return total;
+}
+
+int64_t mst_prim_csr (const graph_csr * self, size_t source, size_t * parent)
+{
+  if (self == NULL || source >= self->size)
+    {
+      return 0;
+    }
+
+  mst_workspace workspace;
+  mst_workspace_create (&workspace, self->size);
+  int64_t total = mst_prim_csr_workspace (self, source, &workspace);
+  if (parent != NULL)
+    {
+      memcpy (parent, workspace.parents, self->size * sizeof (size_t));
+    }
+  mst_workspace_destroy (&workspace);
+  return total;
+}
+
+/* Dense Prim's algorithm */
+
+/*
+ * Keys are wider than the weights so that every int weight is a valid key,
+ * unreached vertices are above INT_MAX and the vertices already in the tree
+ * are INT64_MIN so that they are never relaxed, subtracting 1 maps them to
+ * INT64_MAX with wrapping and keeps the order of the other keys
+ */
+#define MST_DENSE_UNREACHED ((int64_t) INT_MAX + 1)
+#define MST_DENSE_DONE INT64_MIN
+
+static size_t mst_dense_min_scalar (const int64_t * keys, size_t size)
+{
+  size_t min = GRAPH_NONE;
+  int64_t key = MST_DENSE_UNREACHED;
+  for (size_t i = 0; i < size; ++i)
+    {
+      if (keys[i] < key && keys[i] != MST_DENSE_DONE)
+        {
+          key = keys[i];
+          min = i;
+        }
+    }
+  return min;
+}
+
+#if MST_SIMD_AVX2
+__attribute__ ((target ("avx2")))
+static size_t mst_dense_min_avx2 (const int64_t * keys, size_t size)
+{
+  const __m256i one = _mm256_set1_epi64x (1);
+  __m256i best = _mm256_set1_epi64x (INT64_MAX);
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4)
+    {
+      __m256i block = _mm256_loadu_si256 ((const __m256i *) (keys + i));
+      block = _mm256_sub_epi64 (block, one);
+      best = _mm256_blendv_epi8 (best, block,
+                                 _mm256_cmpgt_epi64 (best, block));
+    }
+
+  int64_t lanes[4];
+  _mm256_storeu_si256 ((__m256i *) lanes, best);
+  int64_t min = INT64_MAX;
+  for (int lane = 0; lane < 4; ++lane)
+    {
+      min = lanes[lane] < min ? lanes[lane] : min;
+    }
+  for (; i < size; ++i)
+    {
+      int64_t key = (int64_t) ((uint64_t) keys[i] - 1);
+      min = key < min ? key : min;
+    }
+  // Only unreached and finished vertices are left
+  if (min >= MST_DENSE_UNREACHED - 1)
+    {
+      return GRAPH_NONE;
+    }
+
+  const __m256i key = _mm256_set1_epi64x (min + 1);
+  for (i = 0; i + 4 <= size; i += 4)
+    {
+      __m256i block = _mm256_loadu_si256 ((const __m256i *) (keys + i));
+      int mask = _mm256_movemask_pd (_mm256_castsi256_pd
+                                     (_mm256_cmpeq_epi64 (block, key)));
+      if (mask != 0)
+        {
+          return i + (size_t) __builtin_ctz ((unsigned) mask);
+        }
+    }
+  for (; keys[i] != min + 1; ++i)
+    {
+    }
+  return i;
+}
+#endif
+
+/*
+ * Relax the edges leaving u with keys and parents
+ */
+typedef void (*mst_dense_relax) (const void *input, size_t u,
+                                 int64_t * keys, size_t * parents);
+
+/*
+ * Grow a tree from source, scanning the keys for the next vertex, store the
+ * weight of the edge to the parent of every vertex in distances if it is
+ * not NULL and return the weight of the tree
+ */
+static int64_t mst_dense_grow (size_t size, size_t source,
+                               mst_dense_relax relax, const void *input,
+                               size_t * parents, int *distances)
+{
+  size_t (*scan) (const int64_t *, size_t) = mst_dense_min_scalar;
+#if MST_SIMD_AVX2
+  if (__builtin_cpu_supports ("avx2"))
+    {
+      scan = mst_dense_min_avx2;
+    }
+#endif
+
+  int64_t *keys = calloc (size + 1, sizeof (int64_t));
+  for (size_t i = 0; i < size; ++i)
+    {
+      keys[i] = MST_DENSE_UNREACHED;
+      parents[i] = GRAPH_NONE;
+    }
+  keys[source] = 0;
+
+  int64_t total = 0;
+  size_t u;
+  while ((u = scan (keys, size)) != GRAPH_NONE)
+    {
+      total += keys[u];
+      if (distances != NULL)
+        {
+          distances[u] = (int) keys[u];
+        }
+      keys[u] = MST_DENSE_DONE;
+      relax (input, u, keys, parents);
+    }
+
+  free (keys);
+  return total;
+}
+
+static void mst_dense_relax_graph (const void *input, size_t u,
+                                   int64_t * keys, size_t * parents)
+{
+  const graph_vertex *vertex = ((const graph *) input)->vertices[u];
+  graph_vertex *const *neighbors = vertex->neighbors;
+  const int *weights = vertex->weights;
+  size_t degree = vertex->degree;
+  for (size_t i = 0; i < degree; ++i)
+    {
+      size_t v = neighbors[i]->id;
+      if (weights[i] < keys[v])
+        {
+          keys[v] = weights[i];
+          parents[v] = u;
+        }
+    }
+}
+
+typedef struct
+{
+  const int *weights;
+  size_t size;
+} mst_dense_matrix;
+
+static void mst_dense_relax_matrix (const void *input, size_t u,
+                                    int64_t * keys, size_t * parents)
+{
+  const mst_dense_matrix *matrix = input;
+  const int *row = matrix->weights + u * matrix->size;
+  for (size_t v = 0; v < matrix->size; ++v)
+    {
+      // INT_MAX is no edge in a matrix
+      if (row[v] < keys[v] && row[v] != INT_MAX)
+        {
+          keys[v] = row[v];
+          parents[v] = u;
+        }
+    }
+}
+
+typedef struct
+{
+  size_t size;
+  mst_distance distance;
+  void *data;
+} mst_dense_function;
+
+static void mst_dense_relax_function (const void *input, size_t u,
+                                      int64_t * keys, size_t * parents)
+{
+  const mst_dense_function *function = input;
+  for (size_t v = 0; v < function->size; ++v)
+    {
+      if (keys[v] != MST_DENSE_DONE)
+        {
+          int weight = function->distance (u, v, function->data);
+          if (weight < keys[v])
+            {
+              keys[v] = weight;
+              parents[v] = u;
+            }
+        }
+    }
+}
+
+int64_t mst_prim_dense (const graph * self, graph_vertex * source)
+{
+  if (self == NULL || source == NULL)
+    {
+      return 0;
+    }
+
+  mst_prim_reset (self);
+  size_t *parents = calloc (self->size + 1, sizeof (size_t));
+  int *distances = calloc (self->size + 1, sizeof (int));
+  int64_t total = mst_dense_grow (self->size, source->id,
+                                  mst_dense_relax_graph, self, parents,
+                                  distances);
+  for (size_t i = 0; i < self->size; ++i)
+    {
+      graph_vertex *vertex = self->vertices[i];
+      if (parents[i] != GRAPH_NONE)
+        {
+          vertex->parent = self->vertices[parents[i]];
+          vertex->distance = distances[i];
+        }
+    }
+  source->distance = 0;
+
+  free (parents);
+  free (distances);
+  return total;
+}
+
+/*
+ * Run a dense Prim's algorithm with a caller parent array or a temporary one
+ */
+static int64_t mst_dense_run (size_t size, size_t source, mst_dense_relax relax,
+                              const void *input, size_t * parent)
+{
+  size_t *parents = parent;
+  if (parents == NULL)
+    {
+      parents = calloc (size, sizeof (size_t));
+    }
+  int64_t total = mst_dense_grow (size, source, relax, input, parents, NULL);
+  if (parent == NULL)
+    {
+      free (parents);
+    }
+  return total;
+}
+
+int64_t mst_prim_matrix (const int *weights, size_t size, size_t source,
+                         size_t * parent)
+{
+  if (weights == NULL || source >= size)
+    {
+      return 0;
+    }
+
+  mst_dense_matrix matrix = { weights, size };
+  return mst_dense_run (size, source, mst_dense_relax_matrix, &matrix,
+                        parent);
+}
+
+int64_t mst_prim_distance (size_t size, size_t source, mst_distance distance,
+                           void *data, size_t * parent)
+{
+  if (distance == NULL || source >= size)
+    {
+      return 0;
+    }
+
+  mst_dense_function function = { size, distance, data };
+  return mst_dense_run (size, source, mst_dense_relax_function, &function,
+                        parent);
+}
+
+
+/* Disjoint set with path compression and union by rank */
+
+typedef struct
+{
+  size_t *parents;
+  unsigned char *ranks;
+} disjoint_set;
+
+static void disjoint_set_create (disjoint_set * self, size_t size)
+{
+  self->parents = calloc (size + 1, sizeof (size_t));
+  self->ranks = calloc (size + 1, sizeof (unsigned char));
+  for (size_t i = 0; i < size; ++i)
+    {
+      self->parents[i] = i;
+    }
+}
+
+static void disjoint_set_destroy (disjoint_set * self)
+{
+  free (self->parents);
+  free (self->ranks);
+}
+
+static size_t disjoint_set_find (disjoint_set * self, size_t i)
+{
+  size_t root = i;
+  while (self->parents[root] != root)
+    {
+      root = self->parents[root];
+    }
+  while (self->parents[i] != root)
+    {
+      size_t next = self->parents[i];
+      self->parents[i] = root;
+      i = next;
+    }
+  return root;
+}
+
+/*
+ * Merge the sets of i and j, return false if they were already merged
+ */
+static bool disjoint_set_union (disjoint_set * self, size_t i, size_t j)
+{
+  i = disjoint_set_find (self, i);
+  j = disjoint_set_find (self, j);
+  if (i == j)
+    {
+      return false;
+    }
+  if (self->ranks[i] < self->ranks[j])
+    {
+      size_t tmp = i;
+      i = j;
+      j = tmp;
+    }
+  self->parents[j] = i;
+  if (self->ranks[i] == self->ranks[j])
+    {
+      self->ranks[i]++;
+    }
+  return true;
+}
+
+/*
+ * Store the parent ids of a forest given as a list of edges between ids,
+ * with the tree containing root rooted at root and GRAPH_NONE for root and
+ * the other trees, and the weights of the edges to the parents in
+ * distances if it is not NULL
+ */
+static void mst_tree_orient (size_t size, size_t root, const graph_edge * tree,
+                             size_t count, size_t * parent, int *distances)
+{
+  size_t *offsets = calloc (size + 1, sizeof (size_t));
+  size_t *targets = calloc (2 * count + 1, sizeof (size_t));
+  int *weights = calloc (2 * count + 1, sizeof (int));
+  size_t *fill = calloc (size + 1, sizeof (size_t));
+
+  for (size_t i = 0; i < count; ++i)
+    {
+      offsets[tree[i].source + 1]++;
+      offsets[tree[i].destination + 1]++;
+    }
+  for (size_t i = 0; i < size; ++i)
+    {
+      offsets[i + 1] += offsets[i];
+      fill[i] = offsets[i];
+      parent[i] = GRAPH_NONE;
+    }
+  for (size_t i = 0; i < count; ++i)
+    {
+      targets[fill[tree[i].source]] = tree[i].destination;
+      weights[fill[tree[i].source]++] = tree[i].weight;
+      targets[fill[tree[i].destination]] = tree[i].source;
+      weights[fill[tree[i].destination]++] = tree[i].weight;
+    }
+
+  // Breadth-first traversal, fill is reused as the vertex queue
+  size_t head = 0;
+  size_t tail = 0;
+  fill[tail++] = root;
+  while (head < tail)
+    {
+      size_t u = fill[head++];
+      for (size_t i = offsets[u]; i < offsets[u + 1]; ++i)
+        {
+          size_t v = targets[i];
+          if (v != root && parent[v] == GRAPH_NONE)
+            {
+              parent[v] = u;
+              if (distances != NULL)
+                {
+                  distances[v] = weights[i];
+                }
+              fill[tail++] = v;
+            }
+        }
+    }
+
+  free (offsets);
+  free (targets);
+  free (weights);
+  free (fill);
+}
+
+/*
+ * Orient a spanning forest given as a list of edges from source, set
+ * parent and distance of the graph vertices and return the weight of the
+ * tree containing source
+ */
+static int64_t mst_orient (const graph * self, graph_vertex * source,
+                           const graph_edge * tree, size_t count)
+{
+  size_t *parent = calloc (self->size + 1, sizeof (size_t));
+  int *distances = calloc (self->size + 1, sizeof (int));
+  mst_tree_orient (self->size, source->id, tree, count, parent, distances);
+
+  int64_t total = 0;
+  for (size_t i = 0; i < self->size; ++i)
+    {
+      graph_vertex *vertex = self->vertices[i];
+      vertex->parent = NULL;
+      vertex->distance = INT_MAX;
+      if (parent[i] != GRAPH_NONE)
+        {
+          vertex->parent = self->vertices[parent[i]];
+          vertex->distance = distances[i];
+          total += distances[i];
+        }
+    }
+  source->distance = 0;
+
+  free (parent);
+  free (distances);
+  return total;
+}
+
+static int graph_edge_compare (const void *a, const void *b)
+{
+  const graph_edge *x = a;
+  const graph_edge *y = b;
+
+  if (x->weight != y->weight)
+    {
+      return x->weight < y->weight ? -1 : 1;
+    }
+  if (x->source != y->source)
+    {
+      return x->source < y->source ? -1 : 1;
+    }
+  if (x->destination != y->destination)
+    {
+      return x->destination < y->destination ? -1 : 1;
+    }
+  return 0;
+}
+
+/* Euclidean MST with a k-d tree */
+
+/* Maximum number of points in a leaf of the k-d tree */
+#define KD_LEAF_SIZE 8
+
+typedef struct
+{
+  size_t begin;                 // points in [begin, end) of the tree order
+  size_t end;
+  size_t children[2];           // GRAPH_NONE for a leaf
+  size_t component;             // shared by all the points, or GRAPH_NONE
+} kd_node;
+
+typedef struct
+{
+  size_t dimension;
+  double *points;               // coordinates in tree order
+  size_t *ids;                  // original index of the points in tree order
+  size_t *components;           // component of the points in tree order
+  kd_node *nodes;
+  size_t count;                 // number of nodes
+  double *lower;                // bounding box of every node
+  double *upper;
+} kd_tree;
+
+/*
+ * Reorder ids so that the k-th smallest coordinate along axis sits at k,
+ * with smaller coordinates before it and larger ones after
+ */
+static void kd_select (const double *points, size_t dimension, size_t *ids,
+                       size_t begin, size_t end, size_t k, size_t axis)
+{
+  while (end - begin > 1)
+    {
+      // Three-way partition, points with equal coordinates are common
+      double pivot = points[ids[begin + (end - begin) / 2] * dimension + axis];
+      size_t less = begin;
+      size_t greater = end;
+      size_t i = begin;
+      while (i < greater)
+        {
+          double value = points[ids[i] * dimension + axis];
+          size_t tmp = ids[i];
+          if (value < pivot)
+            {
+              ids[i++] = ids[less];
+              ids[less++] = tmp;
+            }
+          else if (value > pivot)
+            {
+              ids[i] = ids[--greater];
+              ids[greater] = tmp;
+            }
+          else
+            {
+              ++i;
+            }
+        }
+      if (k < less)
+        {
+          end = less;
+        }
+      else if (k >= greater)
+        {
+          begin = greater;
+        }
+      else
+        {
+          return;
+        }
+    }
+}
+
+/*
+ * Build the subtree of the points [begin, end) of ids and return its node
+ */
+static size_t kd_build (kd_tree * self, const double *points, size_t begin,
+                        size_t end)
+{
+  size_t dimension = self->dimension;
+  size_t n = self->count++;
+  kd_node *node = &self->nodes[n];
+  double *lower = &self->lower[n * dimension];
+  double *upper = &self->upper[n * dimension];
+
+  node->begin = begin;
+  node->end = end;
+  node->children[0] = GRAPH_NONE;
+  node->children[1] = GRAPH_NONE;
+  for (size_t d = 0; d < dimension; ++d)
+    {
+      lower[d] = HUGE_VAL;
+      upper[d] = -HUGE_VAL;
+    }
+  for (size_t i = begin; i < end; ++i)
+    {
+      const double *point = &points[self->ids[i] * dimension];
+      for (size_t d = 0; d < dimension; ++d)
+        {
+          lower[d] = point[d] < lower[d] ? point[d] : lower[d];
+          upper[d] = point[d] > upper[d] ? point[d] : upper[d];
+        }
+    }
+  if (end - begin <= KD_LEAF_SIZE)
+    {
+      return n;
+    }
+
+  // Split at the median of the widest side of the box
+  size_t axis = 0;
+  for (size_t d = 1; d < dimension; ++d)
+    {
+      if (upper[d] - lower[d] > upper[axis] - lower[axis])
+        {
+          axis = d;
+        }
+    }
+  size_t middle = begin + (end - begin) / 2;
+  kd_select (points, dimension, self->ids, begin, end, middle, axis);
+  size_t left = kd_build (self, points, begin, middle);
+  size_t right = kd_build (self, points, middle, end);
+  self->nodes[n].children[0] = left;
+  self->nodes[n].children[1] = right;
+  return n;
+}
+
+static void kd_create (kd_tree * self, const double *points, size_t count,
+                       size_t dimension)
+{
+  size_t capacity = 2 * (count / (KD_LEAF_SIZE / 2) + 1);
+  self->dimension = dimension;
+  self->points = calloc (count * dimension + 1, sizeof (double));
+  self->ids = calloc (count + 1, sizeof (size_t));
+  self->components = calloc (count + 1, sizeof (size_t));
+  self->nodes = calloc (capacity, sizeof (kd_node));
+  self->lower = calloc (capacity * dimension, sizeof (double));
+  self->upper = calloc (capacity * dimension, sizeof (double));
+  self->count = 0;
+
+  for (size_t i = 0; i < count; ++i)
+    {
+      self->ids[i] = i;
+    }
+  kd_build (self, points, 0, count);
+  for (size_t i = 0; i < count; ++i)
+    {
+      memcpy (&self->points[i * dimension], &points[self->ids[i] * dimension],
+              dimension * sizeof (double));
+    }
+}
+
+static void kd_destroy (kd_tree * self)
+{
+  free (self->points);
+  free (self->ids);
+  free (self->components);
+  free (self->nodes);
+  free (self->lower);
+  free (self->upper);
+}
+
+/*
+ * Set the component of the nodes whose points are all in one component,
+ * children always come after their parent
+ */
+static void kd_label (kd_tree * self)
+{
+  for (size_t n = self->count; n-- > 0;)
+    {
+      kd_node *node = &self->nodes[n];
+      if (node->children[0] == GRAPH_NONE)
+        {
+          node->component = self->components[node->begin];
+          for (size_t i = node->begin + 1; i < node->end; ++i)
+            {
+              if (self->components[i] != node->component)
+                {
+                  node->component = GRAPH_NONE;
+                  break;
+                }
+            }
+        }
+      else
+        {
+          size_t left = self->nodes[node->children[0]].component;
+          size_t right = self->nodes[node->children[1]].component;
+          node->component = left == right ? left : GRAPH_NONE;
+        }
+    }
+}
+
+static double kd_box_distance (const kd_tree * self, size_t n,
+                               const double *point)
+{
+  const double *lower = &self->lower[n * self->dimension];
+  const double *upper = &self->upper[n * self->dimension];
+  double distance = 0;
+  for (size_t d = 0; d < self->dimension; ++d)
+    {
+      double gap = point[d] < lower[d] ? lower[d] - point[d]
+        : point[d] > upper[d] ? point[d] - upper[d] : 0;
+      distance += gap * gap;
+    }
+  return distance;
+}
+
+/*
+ * Find the nearest point of another component than the one of point i
+ * closer than *best (squared), update *best and *nearest
+ */
+static void kd_nearest (const kd_tree * self, size_t n, size_t i,
+                        double *best, size_t *nearest)
+{
+  const kd_node *node = &self->nodes[n];
+  size_t component = self->components[i];
+  const double *point = &self->points[i * self->dimension];
+  if (node->component == component)
+    {
+      return;
+    }
+
+  if (node->children[0] == GRAPH_NONE)
+    {
+      for (size_t j = node->begin; j < node->end; ++j)
+        {
+          if (self->components[j] == component)
+            {
+              continue;
+            }
+          const double *other = &self->points[j * self->dimension];
+          double distance = 0;
+          for (size_t d = 0; d < self->dimension; ++d)
+            {
+              distance += (point[d] - other[d]) * (point[d] - other[d]);
+            }
+          if (distance < *best)
+            {
+              *best = distance;
+              *nearest = j;
+            }
+        }
+      return;
+    }
+
+  // Visit the closer child first so that the other one is likely pruned
+  double distances[2];
+  for (int k = 0; k < 2; ++k)
+    {
+      distances[k] = kd_box_distance (self, node->children[k], point);
+    }
+  int first = distances[1] < distances[0];
+  for (int k = 0; k < 2; ++k)
+    {
+      int child = k == 0 ? first : !first;
+      if (distances[child] < *best)
+        {
+          kd_nearest (self, node->children[child], i, best, nearest);
+        }
+    }
+}
+
+double mst_euclidean (const double *points, size_t count, size_t dimension,
+                      size_t * parent)
+{
+  if (points == NULL || count == 0 || dimension == 0)
+    {
+      return 0;
+    }
+
+  kd_tree tree;
+  kd_create (&tree, points, count, dimension);
+  disjoint_set set;
+  disjoint_set_create (&set, count);
+  graph_edge *edges = calloc (count, sizeof (graph_edge));
+  double *bests = calloc (count, sizeof (double));
+  size_t *sources = calloc (count, sizeof (size_t));
+  size_t *targets = calloc (count, sizeof (size_t));
+
+  // Boruvka rounds over the tree order, the nearest point of another
+  // component is searched from every point with the best distance of its
+  // component as a bound
+  size_t edge_count = 0;
+  double total = 0;
+  while (edge_count + 1 < count)
+    {
+      for (size_t i = 0; i < count; ++i)
+        {
+          tree.components[i] = disjoint_set_find (&set, i);
+          bests[i] = HUGE_VAL;
+          targets[i] = GRAPH_NONE;
+        }
+      kd_label (&tree);
+
+      for (size_t i = 0; i < count; ++i)
+        {
+          size_t component = tree.components[i];
+          size_t nearest = GRAPH_NONE;
+          kd_nearest (&tree, 0, i, &bests[component], &nearest);
+          if (nearest != GRAPH_NONE)
+            {
+              sources[component] = i;
+              targets[component] = nearest;
+            }
+        }
+
+      size_t added = edge_count;
+      for (size_t c = 0; c < count; ++c)
+        {
+          if (targets[c] != GRAPH_NONE
+              && disjoint_set_union (&set, sources[c], targets[c]))
+            {
+              edges[edge_count].source = tree.ids[sources[c]];
+              edges[edge_count].destination = tree.ids[targets[c]];
+              ++edge_count;
+              total += sqrt (bests[c]);
+            }
+        }
+      if (edge_count == added)
+        {
+          break;
+        }
+    }
+
+  if (parent != NULL)
+    {
+      mst_tree_orient (count, 0, edges, edge_count, parent, NULL);
+    }
+
+  free (bests);
+  free (sources);
+  free (targets);
+  free (edges);
+  disjoint_set_destroy (&set);
+  kd_destroy (&tree);
+  return total;
+}
+
+int64_t mst_kruskal (const graph * self, graph_vertex * source)
+{
+  if (self == NULL || source == NULL)
+    {
+      return 0;
+    }
+
+  // Every edge is listed once, from its endpoint with the smallest id
+  size_t count = 0;
+  for (size_t i = 0; i < self->size; ++i)
+    {
+      count += self->vertices[i]->degree;
+    }
+  graph_edge *edges = calloc (count / 2 + 1, sizeof (graph_edge));
+  count = 0;
+  for (size_t i = 0; i < self->size; ++i)
+    {
+      graph_vertex *u = self->vertices[i];
+      for (size_t j = 0; j < u->degree; ++j)
+        {
+          if (u->id < u->neighbors[j]->id)
+            {
+              edges[count].source = u->id;
+              edges[count].destination = u->neighbors[j]->id;
+              edges[count].weight = u->weights[j];
+              ++count;
+            }
+        }
+    }
+  qsort (edges, count, sizeof (graph_edge), graph_edge_compare);
+
+  disjoint_set set;
+  disjoint_set_create (&set, self->size);
+  size_t tree = 0;
+  for (size_t i = 0; i < count && tree + 1 < self->size; ++i)
+    {
+      if (disjoint_set_union (&set, edges[i].source, edges[i].destination))
+        {
+          edges[tree++] = edges[i];
+        }
+    }
+  disjoint_set_destroy (&set);
+
+  int64_t total = mst_orient (self, source, edges, tree);
+  free (edges);
+  return total;
+}
+
+/*
+ * Compare edges by weight then endpoints so that every edge is distinct
+ */
+static bool mst_edge_less (int weight, size_t u, size_t v, int other_weight,
+                           size_t x, size_t y)
+{
+  if (weight != other_weight)
+    {
+      return weight < other_weight;
+    }
+  size_t low = u < v ? u : v;
+  size_t other_low = x < y ? x : y;
+  if (low != other_low)
+    {
+      return low < other_low;
+    }
+  return (u < v ? v : u) < (x < y ? y : x);
+}
+
+/*
+ * State shared by the thread team of Boruvka's algorithm, every component
+ * is named after the root of its disjoint set
+ */
+typedef struct
+{
+  const graph *graph;
+  pthread_barrier_t barrier;
+  size_t *components;           // component of every vertex
+  size_t *offsets;              // live edges of vertex i start at offsets[i]
+  size_t *live;                 // number of live edges of every vertex
+  size_t *neighbors;            // edges leaving the component of the vertex
+  int *edge_weights;
+  size_t *targets;              // cheapest outgoing edge of every vertex
+  int *weights;
+  size_t *cheapest;             // vertex of the cheapest edge of a component
+  size_t *labels;               // component of every component after a round
+  size_t *roots;                // components that are still roots
+  size_t root_count;
+  disjoint_set set;
+  graph_edge *tree;
+  size_t count;
+  bool merged;
+} boruvka_state;
+
+typedef struct
+{
+  boruvka_state *state;
+  size_t index;
+  size_t begin;                 // vertices of this thread
+  size_t end;
+} boruvka_task;
+
+/*
+ * Find the cheapest outgoing edge of every vertex of a thread and drop the
+ * edges that no longer leave its component
+ */
+static void mst_boruvka_scan (boruvka_state * state, size_t begin,
+                              size_t end)
+{
+  const size_t *components = state->components;
+  for (size_t i = begin; i < end; ++i)
+    {
+      size_t component = components[i];
+      size_t *neighbors = state->neighbors + state->offsets[i];
+      int *weights = state->edge_weights + state->offsets[i];
+      size_t live = state->live[i];
+      size_t target = GRAPH_NONE;
+      int weight = INT_MAX;
+      for (size_t j = 0; j < live;)
+        {
+          size_t v = neighbors[j];
+          if (components[v] == component)
+            {
+              --live;
+              neighbors[j] = neighbors[live];
+              weights[j] = weights[live];
+              continue;
+            }
+          if (target == GRAPH_NONE
+              || mst_edge_less (weights[j], i, v, weight, i, target))
+            {
+              target = v;
+              weight = weights[j];
+            }
+          ++j;
+        }
+      state->live[i] = live;
+      state->targets[i] = target;
+      state->weights[i] = weight;
+      state->cheapest[i] = GRAPH_NONE;
+    }
+}
+
+/*
+ * Keep the cheapest edge of the vertices of a thread in their components,
+ * concurrent threads race with compare and swap
+ */
+static void mst_boruvka_reduce (boruvka_state * state, size_t begin,
+                                size_t end)
+{
+  const size_t *targets = state->targets;
+  const int *weights = state->weights;
+  for (size_t i = begin; i < end; ++i)
+    {
+      if (targets[i] == GRAPH_NONE)
+        {
+          continue;
+        }
+      size_t *slot = &state->cheapest[state->components[i]];
+      size_t best = __atomic_load_n (slot, __ATOMIC_RELAXED);
+      while (best == GRAPH_NONE
+             || mst_edge_less (weights[i], i, targets[i], weights[best],
+                               best, targets[best]))
+        {
+          if (__atomic_compare_exchange_n (slot, &best, i, true,
+                                           __ATOMIC_RELAXED,
+                                           __ATOMIC_RELAXED))
+            {
+              break;
+            }
+        }
+    }
+}
+
+/*
+ * Merge the components along their cheapest edges, only the root
+ * components are visited so that the rounds shrink with the forest
+ */
+static void mst_boruvka_contract (boruvka_state * state)
+{
+  state->merged = false;
+  for (size_t k = 0; k < state->root_count; ++k)
+    {
+      size_t u = state->cheapest[state->roots[k]];
+      if (u != GRAPH_NONE
+          && disjoint_set_union (&state->set, u, state->targets[u]))
+        {
+          graph_edge *edge = &state->tree[state->count++];
+          edge->source = u;
+          edge->destination = state->targets[u];
+          edge->weight = state->weights[u];
+          state->merged = true;
+        }
+    }
+
+  size_t count = 0;
+  for (size_t k = 0; k < state->root_count; ++k)
+    {
+      size_t c = state->roots[k];
+      state->labels[c] = disjoint_set_find (&state->set, c);
+      if (state->labels[c] == c)
+        {
+          state->roots[count++] = c;
+        }
+    }
+  state->root_count = count;
+}
+
+/*
+ * Rounds of one thread of the team, the first thread also contracts
+ */
+static void *mst_boruvka_run (void *data)
+{
+  boruvka_task *task = data;
+  boruvka_state *state = task->state;
+  const graph *g = state->graph;
+
+  // Copy the adjacency of the vertices of this thread
+  for (size_t i = task->begin; i < task->end; ++i)
+    {
+      const graph_vertex *u = g->vertices[i];
+      size_t offset = state->offsets[i];
+      for (size_t j = 0; j < u->degree; ++j)
+        {
+          state->neighbors[offset + j] = u->neighbors[j]->id;
+          state->edge_weights[offset + j] = u->weights[j];
+        }
+      state->live[i] = u->degree;
+    }
+  pthread_barrier_wait (&state->barrier);
+
+  for (;;)
+    {
+      mst_boruvka_scan (state, task->begin, task->end);
+      pthread_barrier_wait (&state->barrier);
+      mst_boruvka_reduce (state, task->begin, task->end);
+      pthread_barrier_wait (&state->barrier);
+      if (task->index == 0)
+        {
+          mst_boruvka_contract (state);
+        }
+      pthread_barrier_wait (&state->barrier);
+      if (!state->merged)
+        {
+          break;
+        }
+      for (size_t i = task->begin; i < task->end; ++i)
+        {
+          state->components[i] = state->labels[state->components[i]];
+        }
+      pthread_barrier_wait (&state->barrier);
+    }
+  return NULL;
+}
+
+int64_t mst_boruvka (const graph * self, graph_vertex * source, size_t threads)
+{
+  if (self == NULL || source == NULL)
+    {
+      return 0;
+    }
+  if (threads == 0)
+    {
+      threads = mst_default_threads ();
+    }
+  if (threads > self->size)
+    {
+      threads = self->size;
+    }
+
+  boruvka_state state;
+  size_t size = self->size;
+  state.graph = self;
+  state.components = calloc (size, sizeof (size_t));
+  state.offsets = calloc (size + 1, sizeof (size_t));
+  state.live = calloc (size, sizeof (size_t));
+  state.targets = calloc (size, sizeof (size_t));
+  state.weights = calloc (size, sizeof (int));
+  state.cheapest = calloc (size, sizeof (size_t));
+  state.labels = calloc (size, sizeof (size_t));
+  state.roots = calloc (size, sizeof (size_t));
+  state.root_count = size;
+  state.tree = calloc (size, sizeof (graph_edge));
+  state.count = 0;
+  state.merged = false;
+  for (size_t i = 0; i < size; ++i)
+    {
+      state.components[i] = i;
+      state.roots[i] = i;
+      state.offsets[i + 1] = state.offsets[i] + self->vertices[i]->degree;
+    }
+  state.neighbors = calloc (state.offsets[size] + 1, sizeof (size_t));
+  state.edge_weights = calloc (state.offsets[size] + 1, sizeof (int));
+  disjoint_set_create (&state.set, size);
+  pthread_barrier_init (&state.barrier, NULL, (unsigned) threads);
+
+  // One team of threads for all the rounds
+  boruvka_task *tasks = calloc (threads, sizeof (boruvka_task));
+  for (size_t t = 0; t < threads; ++t)
+    {
+      tasks[t].state = &state;
+      tasks[t].index = t;
+      tasks[t].begin = size * t / threads;
+      tasks[t].end = size * (t + 1) / threads;
+    }
+  mst_parallel_run (mst_boruvka_run, tasks, sizeof (boruvka_task), threads);
+
+  pthread_barrier_destroy (&state.barrier);
+  disjoint_set_destroy (&state.set);
+  int64_t total = mst_orient (self, source, state.tree, state.count);
+  free (state.components);
+  free (state.offsets);
+  free (state.live);
+  free (state.neighbors);
+  free (state.edge_weights);
+  free (state.targets);
+  free (state.weights);
+  free (state.cheapest);
+  free (state.labels);
+  free (state.roots);
+  free (state.tree);
+  free (tasks);
+  return total;
+}
+
+/*
+ * Check whether a graph has at least one edge every MST_DENSE_RATIO pairs
+ * of vertices
+ */
+static bool mst_is_dense (const graph * self)
+{
+  size_t degrees = 0;
+  for (size_t i = 0; i < self->size; ++i)
+    {
+      degrees += self->vertices[i]->degree;
+    }
+  // degrees counts every edge twice and size * size every pair twice
+  return degrees * MST_DENSE_RATIO >= self->size * self->size;
+}
+
+int64_t mst_run (const graph * self, graph_vertex * source, mst_engine engine)
+{
+  switch (engine)
+    {
+    case MST_KRUSKAL:
+      return mst_kruskal (self, source);
+    case MST_BORUVKA:
+      return mst_boruvka (self, source, 0);
+    case MST_DENSE:
+      return mst_prim_dense (self, source);
+    case MST_AUTO:
+      if (self != NULL && mst_is_dense (self))
+        {
+          return mst_prim_dense (self, source);
+        }
+      return mst_prim (self, source);
+    case MST_PRIM:
+    default:
+      return mst_prim (self, source);
+    }
+}
+
+
+/* Batch of independent Minimum Spanning Trees */
+
+static void mst_batch_solve (mst_batch * self, mst_batch_worker * worker,
+                             size_t i)
+{
+  graph *g = self->graphs[i];
+  int64_t total = 0;
+  if (g != NULL && g->size != 0)
+    {
+      total = mst_prim_queue (g, g->vertices[0], &worker->queue);
+    }
+  if (self->totals != NULL)
+    {
+      self->totals[i] = total;
+    }
+  if (g != NULL && self->parents != NULL && self->parents[i] != NULL)
+    {
+      for (size_t j = 0; j < g->size; ++j)
+        {
+          graph_vertex *parent = g->vertices[j]->parent;
+          self->parents[i][j] = parent != NULL ? parent->id : GRAPH_NONE;
+        }
+    }
+}
+
+/*
+ * Take the first graph of a worker, GRAPH_NONE when it has none left
+ */
+static size_t mst_batch_take (mst_batch_worker * worker)
+{
+  size_t i = GRAPH_NONE;
+  pthread_mutex_lock (&worker->lock);
+  if (worker->begin < worker->end)
+    {
+      i = worker->begin++;
+    }
+  pthread_mutex_unlock (&worker->lock);
+  return i;
+}
+
+/*
+ * Move the last half of the graphs of another worker to an idle worker and
+ * return the first one, GRAPH_NONE when every worker is out of graphs
+ */
+static size_t mst_batch_steal (mst_batch * self, mst_batch_worker * worker)
+{
+  size_t index = (size_t) (worker - self->workers);
+  for (size_t k = 1; k < self->threads; ++k)
+    {
+      mst_batch_worker *victim =
+        &self->workers[(index + k) % self->threads];
+      size_t begin = 0;
+      size_t end = 0;
+      pthread_mutex_lock (&victim->lock);
+      if (victim->begin < victim->end)
+        {
+          end = victim->end;
+          begin = end - (end - victim->begin + 1) / 2;
+          victim->end = begin;
+        }
+      pthread_mutex_unlock (&victim->lock);
+
+      if (begin < end)
+        {
+          pthread_mutex_lock (&worker->lock);
+          worker->begin = begin + 1;
+          worker->end = end;
+          pthread_mutex_unlock (&worker->lock);
+          return begin;
+        }
+    }
+  return GRAPH_NONE;
+}
+
+static void mst_batch_work (mst_batch * self, mst_batch_worker * worker)
+{
+  for (;;)
+    {
+      size_t i = mst_batch_take (worker);
+      if (i == GRAPH_NONE)
+        {
+          i = mst_batch_steal (self, worker);
+        }
+      if (i == GRAPH_NONE)
+        {
+          return;
+        }
+      mst_batch_solve (self, worker, i);
+    }
+}
+
+static void *mst_batch_thread (void *data)
+{
+  mst_batch_worker *worker = data;
+  mst_batch *self = worker->batch;
+  size_t generation = 0;
+
+  for (;;)
+    {
+      pthread_mutex_lock (&self->lock);
+      while (!self->stop && self->generation == generation)
+        {
+          pthread_cond_wait (&self->start, &self->lock);
+        }
+      if (self->stop)
+        {
+          pthread_mutex_unlock (&self->lock);
+          return NULL;
+        }
+      generation = self->generation;
+      pthread_mutex_unlock (&self->lock);
+
+      mst_batch_work (self, worker);
+
+      pthread_mutex_lock (&self->lock);
+      if (--self->running == 0)
+        {
+          pthread_cond_signal (&self->done);
+        }
+      pthread_mutex_unlock (&self->lock);
+    }
+}
+
+void mst_batch_create (mst_batch * self, size_t threads)
+{
+  if (self == NULL)
+    {
+      return;
+    }
+
+  self->threads = threads != 0 ? threads : mst_default_threads ();
+  self->handles = calloc (self->threads, sizeof (pthread_t));
+  self->workers = calloc (self->threads, sizeof (mst_batch_worker));
+  pthread_mutex_init (&self->lock, NULL);
+  pthread_cond_init (&self->start, NULL);
+  pthread_cond_init (&self->done, NULL);
+  self->generation = 0;
+  self->running = 0;
+  self->stop = 0;
+  self->graphs = NULL;
+  self->totals = NULL;
+  self->parents = NULL;
+
+  for (size_t t = 0; t < self->threads; ++t)
+    {
+      mst_batch_worker *worker = &self->workers[t];
+      pthread_mutex_init (&worker->lock, NULL);
+      queue_create (&worker->queue);
+      worker->batch = self;
+      if (t != 0)
+        {
+          pthread_create (&self->handles[t], NULL, mst_batch_thread, worker);
+        }
+    }
+}
+
+void mst_batch_destroy (mst_batch * self)
+{
+  if (self == NULL || self->workers == NULL)
+    {
+      return;
+    }
+
+  pthread_mutex_lock (&self->lock);
+  self->stop = 1;
+  pthread_cond_broadcast (&self->start);
+  pthread_mutex_unlock (&self->lock);
+  for (size_t t = 0; t < self->threads; ++t)
+    {
+      if (t != 0)
+        {
+          pthread_join (self->handles[t], NULL);
+        }
+      queue_destroy (&self->workers[t].queue);
+      pthread_mutex_destroy (&self->workers[t].lock);
+    }
+
+  pthread_mutex_destroy (&self->lock);
+  pthread_cond_destroy (&self->start);
+  pthread_cond_destroy (&self->done);
+  free (self->handles);
+  free (self->workers);
+  self->handles = NULL;
+  self->workers = NULL;
+  self->threads = 0;
+}
+
+void mst_batch_run (mst_batch * self, graph * const *graphs, size_t count,
+                    int64_t * totals, size_t ** parents)
+{
+  if (self == NULL || self->workers == NULL || graphs == NULL)
+    {
+      return;
+    }
+
+  // Contiguous ranges keep neighboring graphs on the same thread until
+  // some thread runs out of work
+  for (size_t t = 0; t < self->threads; ++t)
+    {
+      mst_batch_worker *worker = &self->workers[t];
+      pthread_mutex_lock (&worker->lock);
+      worker->begin = count * t / self->threads;
+      worker->end = count * (t + 1) / self->threads;
+      pthread_mutex_unlock (&worker->lock);
+    }
+
+  pthread_mutex_lock (&self->lock);
+  self->graphs = graphs;
+  self->totals = totals;
+  self->parents = parents;
+  self->running = self->threads - 1;
+  self->generation++;
+  pthread_cond_broadcast (&self->start);
+  pthread_mutex_unlock (&self->lock);
+
+  mst_batch_work (self, &self->workers[0]);
+
+  pthread_mutex_lock (&self->lock);
+  while (self->running != 0)
+    {
+      pthread_cond_wait (&self->done, &self->lock);
+    }
+  pthread_mutex_unlock (&self->lock);
+}
+
+
+/* Dynamic Minimum Spanning Tree with a link-cut tree */
+
+/*
+ * Every vertex and every tree edge is a node of the link-cut tree, an edge
+ * node sits between its two endpoints so that a path maximum is an edge
+ */
+
+static bool dynamic_is_root (const mst_dynamic * self, size_t x)
+{
+  size_t p = self->nodes[x].parent;
+  return p == GRAPH_NONE
+    || (self->nodes[p].children[0] != x && self->nodes[p].children[1] != x);
+}
+
+static void dynamic_push (mst_dynamic * self, size_t x)
+{
+  mst_dynamic_node *node = &self->nodes[x];
+  if (node->reversed)
+    {
+      size_t tmp = node->children[0];
+      node->children[0] = node->children[1];
+      node->children[1] = tmp;
+      for (int i = 0; i < 2; ++i)
+        {
+          if (node->children[i] != GRAPH_NONE)
+            {
+              self->nodes[node->children[i]].reversed ^= 1;
+            }
+        }
+      node->reversed = 0;
+    }
+}
+
+static void dynamic_update (mst_dynamic * self, size_t x)
+{
+  mst_dynamic_node *node = &self->nodes[x];
+  size_t max = x;
+  for (int i = 0; i < 2; ++i)
+    {
+      size_t child = node->children[i];
+      if (child != GRAPH_NONE
+          && self->nodes[self->nodes[child].max].weight >
+          self->nodes[max].weight)
+        {
+          max = self->nodes[child].max;
+        }
+    }
+  node->max = max;
+}
+
+static void dynamic_rotate (mst_dynamic * self, size_t x)
+{
+  size_t p = self->nodes[x].parent;
+  size_t g = self->nodes[p].parent;
+  int side = self->nodes[p].children[1] == x;
+  size_t inner = self->nodes[x].children[!side];
+
+  if (!dynamic_is_root (self, p))
+    {
+      self->nodes[g].children[self->nodes[g].children[1] == p] = x;
+    }
+  self->nodes[x].parent = g;
+  self->nodes[x].children[!side] = p;
+  self->nodes[p].parent = x;
+  self->nodes[p].children[side] = inner;
+  if (inner != GRAPH_NONE)
+    {
+      self->nodes[inner].parent = p;
+    }
+  dynamic_update (self, p);
+  dynamic_update (self, x);
+}
+
+static void dynamic_splay (mst_dynamic * self, size_t x)
+{
+  // Push the reversal flags down from the root of the splay tree
+  size_t top = 0;
+  size_t y = x;
+  self->stack[top++] = y;
+  while (!dynamic_is_root (self, y))
+    {
+      y = self->nodes[y].parent;
+      self->stack[top++] = y;
+    }
+  while (top > 0)
+    {
+      dynamic_push (self, self->stack[--top]);
+    }
+
+  while (!dynamic_is_root (self, x))
+    {
+      size_t p = self->nodes[x].parent;
+      if (!dynamic_is_root (self, p))
+        {
+          size_t g = self->nodes[p].parent;
+          bool line = (self->nodes[g].children[0] == p)
+            == (self->nodes[p].children[0] == x);
+          dynamic_rotate (self, line ? p : x);
+        }
+      dynamic_rotate (self, x);
+    }
+}
+
+/*
+ * Make the path from the root of the tree to x preferred, x ends up at the
+ * root of its splay tree
+ */
+static void dynamic_access (mst_dynamic * self, size_t x)
+{
+  size_t last = GRAPH_NONE;
+  for (size_t y = x; y != GRAPH_NONE; y = self->nodes[y].parent)
+    {
+      dynamic_splay (self, y);
+      self->nodes[y].children[1] = last;
+      dynamic_update (self, y);
+      last = y;
+    }
+  dynamic_splay (self, x);
+}
+
+static void dynamic_evert (mst_dynamic * self, size_t x)
+{
+  dynamic_access (self, x);
+  self->nodes[x].reversed ^= 1;
+}
+
+static size_t dynamic_find_root (mst_dynamic * self, size_t x)
+{
+  dynamic_access (self, x);
+  dynamic_push (self, x);
+  while (self->nodes[x].children[0] != GRAPH_NONE)
+    {
+      x = self->nodes[x].children[0];
+      dynamic_push (self, x);
+    }
+  dynamic_splay (self, x);
+  return x;
+}
+
+static void dynamic_link (mst_dynamic * self, size_t x, size_t y)
+{
+  dynamic_evert (self, x);
+  self->nodes[x].parent = y;
+}
+
+/*
+ * Remove the link between two adjacent nodes
+ */
+static void dynamic_cut (mst_dynamic * self, size_t x, size_t y)
+{
+  dynamic_evert (self, x);
+  dynamic_access (self, y);
+  self->nodes[y].children[0] = GRAPH_NONE;
+  self->nodes[x].parent = GRAPH_NONE;
+  dynamic_update (self, y);
+}
+
+/*
+ * Take a node from the free list or the end of the pool
+ */
+static size_t dynamic_node (mst_dynamic * self, size_t source,
+                            size_t destination, int weight)
+{
+  size_t x = self->free;
+  if (x != GRAPH_NONE)
+    {
+      self->free = self->nodes[x].parent;
+    }
+  else
+    {
+      if (self->count == self->capacity)
+        {
+          self->capacity = self->capacity < 16 ? 16 : 2 * self->capacity;
+          self->nodes =
+            realloc (self->nodes, self->capacity * sizeof (mst_dynamic_node));
+          self->stack =
+            realloc (self->stack, self->capacity * sizeof (size_t));
+        }
+      x = self->count++;
+    }
+
+  mst_dynamic_node *node = &self->nodes[x];
+  node->parent = GRAPH_NONE;
+  node->children[0] = GRAPH_NONE;
+  node->children[1] = GRAPH_NONE;
+  node->max = x;
+  node->source = source;
+  node->destination = destination;
+  node->next[0] = GRAPH_NONE;
+  node->next[1] = GRAPH_NONE;
+  node->weight = weight;
+  node->reversed = 0;
+  return x;
+}
+
+/*
+ * Node of a vertex, created on first use so that vertices may be added to
+ * the graph after the forest
+ */
+static size_t dynamic_vertex (mst_dynamic * self, size_t id)
+{
+  if (id >= self->vertex_count)
+    {
+      size_t count = self->graph->size > id ? self->graph->size : id + 1;
+      self->vertex_nodes =
+        realloc (self->vertex_nodes, count * sizeof (size_t));
+      self->tree_edges = realloc (self->tree_edges, count * sizeof (size_t));
+      self->marks = realloc (self->marks, count * sizeof (size_t));
+      for (int side = 0; side < 2; ++side)
+        {
+          self->queues[side] =
+            realloc (self->queues[side], count * sizeof (size_t));
+        }
+      for (size_t i = self->vertex_count; i < count; ++i)
+        {
+          self->vertex_nodes[i] = GRAPH_NONE;
+          self->tree_edges[i] = GRAPH_NONE;
+          self->marks[i] = 0;
+        }
+      self->vertex_count = count;
+    }
+  if (self->vertex_nodes[id] == GRAPH_NONE)
+    {
+      // Vertex nodes weigh less than any edge and never hold a path maximum
+      self->vertex_nodes[id] = dynamic_node (self, id, GRAPH_NONE, INT_MIN);
+    }
+  return self->vertex_nodes[id];
+}
+
+/*
+ * Link to the next tree edge around a vertex id
+ */
+static size_t *dynamic_next (mst_dynamic * self, size_t edge, size_t id)
+{
+  return &self->nodes[edge].next[self->nodes[edge].source == id ? 0 : 1];
+}
+
+static void dynamic_link_edge (mst_dynamic * self, size_t u, size_t v,
+                               int weight)
+{
+  size_t x = dynamic_vertex (self, u);
+  size_t y = dynamic_vertex (self, v);
+  size_t edge = dynamic_node (self, u, v, weight);
+  dynamic_link (self, x, edge);
+  dynamic_link (self, edge, y);
+
+  self->nodes[edge].next[0] = self->tree_edges[u];
+  self->tree_edges[u] = edge;
+  self->nodes[edge].next[1] = self->tree_edges[v];
+  self->tree_edges[v] = edge;
+  self->edges++;
+  self->total += weight;
+}
+
+static void dynamic_unlist_edge (mst_dynamic * self, size_t edge, size_t id)
+{
+  size_t *link = &self->tree_edges[id];
+  while (*link != edge)
+    {
+      link = dynamic_next (self, *link, id);
+    }
+  *link = *dynamic_next (self, edge, id);
+}
+
+static void dynamic_cut_edge (mst_dynamic * self, size_t edge)
+{
+  mst_dynamic_node *node = &self->nodes[edge];
+  size_t u = node->source;
+  size_t v = node->destination;
+  dynamic_cut (self, self->vertex_nodes[u], edge);
+  dynamic_cut (self, edge, self->vertex_nodes[v]);
+  dynamic_unlist_edge (self, edge, u);
+  dynamic_unlist_edge (self, edge, v);
+
+  node = &self->nodes[edge];
+  self->edges--;
+  self->total -= node->weight;
+  node->source = GRAPH_NONE;
+  node->parent = self->free;
+  self->free = edge;
+}
+
+/*
+ * Tree edge between two vertex ids with a given weight, GRAPH_NONE if there
+ * is none
+ */
+static size_t dynamic_find_edge (mst_dynamic * self, size_t u, size_t v,
+                                 int weight)
+{
+  if (u >= self->vertex_count)
+    {
+      return GRAPH_NONE;
+    }
+  for (size_t edge = self->tree_edges[u]; edge != GRAPH_NONE;
+       edge = *dynamic_next (self, edge, u))
+    {
+      mst_dynamic_node *node = &self->nodes[edge];
+      // Both endpoints must match, a loop at u is never a tree edge
+      if (node->weight == weight
+          && ((node->source == u && node->destination == v)
+              || (node->source == v && node->destination == u)))
+        {
+          return edge;
+        }
+    }
+  return GRAPH_NONE;
+}
+
+/*
+ * Cut a tree edge and link its two trees with the lightest edge between
+ * them, the trees are traversed in lockstep so that only the edges of the
+ * smaller one are scanned
+ */
+static void dynamic_replace_edge (mst_dynamic * self, size_t edge)
+{
+  size_t ends[2] = { self->nodes[edge].source, self->nodes[edge].destination };
+  dynamic_cut_edge (self, edge);
+
+  size_t stamps[2] = { self->stamp + 1, self->stamp + 2 };
+  size_t heads[2] = { 0, 0 };
+  size_t tails[2] = { 1, 1 };
+  self->stamp += 2;
+  for (int side = 0; side < 2; ++side)
+    {
+      self->queues[side][0] = ends[side];
+      self->marks[ends[side]] = stamps[side];
+    }
+
+  int side = 0;
+  while (heads[side] < tails[side])
+    {
+      size_t u = self->queues[side][heads[side]++];
+      for (size_t e = self->tree_edges[u]; e != GRAPH_NONE;
+           e = *dynamic_next (self, e, u))
+        {
+          size_t v = self->nodes[e].source == u
+            ? self->nodes[e].destination : self->nodes[e].source;
+          if (self->marks[v] != stamps[side])
+            {
+              self->marks[v] = stamps[side];
+              self->queues[side][tails[side]++] = v;
+            }
+        }
+      side = !side;
+    }
+
+  // Every vertex of the smaller tree is stamped, the lightest edge leaving
+  // it reaches the other tree
+  graph_vertex *best = NULL;
+  graph_vertex *other = NULL;
+  int weight = INT_MAX;
+  for (size_t i = 0; i < tails[side]; ++i)
+    {
+      graph_vertex *u = self->graph->vertices[self->queues[side][i]];
+      for (size_t j = 0; j < u->degree; ++j)
+        {
+          if (self->marks[u->neighbors[j]->id] != stamps[side]
+              && (best == NULL || u->weights[j] < weight))
+            {
+              best = u;
+              other = u->neighbors[j];
+              weight = u->weights[j];
+            }
+        }
+    }
+  if (best != NULL)
+    {
+      dynamic_link_edge (self, best->id, other->id, weight);
+    }
+}
+
+void mst_dynamic_create (mst_dynamic * self, graph * graph)
+{
+  if (self == NULL || graph == NULL)
+    {
+      return;
+    }
+
+  self->graph = graph;
+  self->count = 0;
+  self->capacity = 2 * graph->size + 1;
+  self->nodes = calloc (self->capacity, sizeof (mst_dynamic_node));
+  self->stack = calloc (self->capacity, sizeof (size_t));
+  self->vertex_nodes = NULL;
+  self->tree_edges = NULL;
+  self->marks = NULL;
+  self->queues[0] = NULL;
+  self->queues[1] = NULL;
+  self->vertex_count = 0;
+  self->stamp = 0;
+  self->free = GRAPH_NONE;
+  self->edges = 0;
+  self->total = 0;
+
+  for (size_t i = 0; i < graph->size; ++i)
+    {
+      dynamic_vertex (self, i);
+    }
+  for (size_t i = 0; i < graph->size; ++i)
+    {
+      graph_vertex *vertex = graph->vertices[i];
+      if (vertex->parent != NULL)
+        {
+          dynamic_link_edge (self, vertex->id, vertex->parent->id,
+                             vertex->distance);
+        }
+    }
+}
+
+void mst_dynamic_destroy (mst_dynamic * self)
+{
+  if (self == NULL)
+    {
+      return;
+    }
+
+  free (self->nodes);
+  free (self->stack);
+  free (self->vertex_nodes);
+  free (self->tree_edges);
+  free (self->marks);
+  free (self->queues[0]);
+  free (self->queues[1]);
+  self->nodes = NULL;
+  self->stack = NULL;
+  self->vertex_nodes = NULL;
+  self->tree_edges = NULL;
+  self->marks = NULL;
+  self->queues[0] = NULL;
+  self->queues[1] = NULL;
+  self->count = 0;
+  self->capacity = 0;
+  self->vertex_count = 0;
+}
+
+int mst_dynamic_insert (mst_dynamic * self, graph_vertex * source,
+                        graph_vertex * destination, int weight)
+{
+  if (self == NULL || source == NULL || destination == NULL
+      || source == destination)
+    {
+      return 0;
+    }
+
+  size_t u = dynamic_vertex (self, source->id);
+  size_t v = dynamic_vertex (self, destination->id);
+  if (dynamic_find_root (self, u) != dynamic_find_root (self, v))
+    {
+      dynamic_link_edge (self, source->id, destination->id, weight);
+      return 1;
+    }
+
+  // The new edge closes a cycle, it replaces the heaviest edge of the path
+  dynamic_evert (self, u);
+  dynamic_access (self, v);
+  size_t max = self->nodes[v].max;
+  if (self->nodes[max].weight <= weight)
+    {
+      return 0;
+    }
+  dynamic_cut_edge (self, max);
+  dynamic_link_edge (self, source->id, destination->id, weight);
+  return 1;
+}
+
+int mst_dynamic_remove (mst_dynamic * self, graph_vertex * source,
+                        graph_vertex * destination, int weight)
+{
+  if (self == NULL || source == NULL || destination == NULL)
+    {
+      return 0;
+    }
+
+  size_t edge = dynamic_find_edge (self, source->id, destination->id, weight);
+  if (edge == GRAPH_NONE)
+    {
+      return 0;
+    }
+  dynamic_replace_edge (self, edge);
+  return 1;
+}
+
+int mst_dynamic_update (mst_dynamic * self, graph_vertex * source,
+                        graph_vertex * destination, int weight,
+                        int new_weight)
+{
+  if (self == NULL || source == NULL || destination == NULL)
+    {
+      return 0;
+    }
+
+  size_t edge = dynamic_find_edge (self, source->id, destination->id, weight);
+  if (edge == GRAPH_NONE)
+    {
+      // A lighter edge outside the forest may close a cheaper cycle
+      return new_weight < weight
+        ? mst_dynamic_insert (self, source, destination, new_weight) : 0;
+    }
+  if (new_weight <= weight)
+    {
+      dynamic_access (self, edge);
+      self->nodes[edge].weight = new_weight;
+      dynamic_update (self, edge);
+      self->total += (int64_t) new_weight - weight;
+      return 1;
+    }
+  // A heavier tree edge competes with the other edges across its cut
+  dynamic_replace_edge (self, edge);
+  return 1;
+}
+
+/*
+ * Rightmost node of the left subtree of a splay root, which is splayed
+ */
+static size_t dynamic_predecessor (mst_dynamic * self, size_t x)
+{
+  x = self->nodes[x].children[0];
+  if (x == GRAPH_NONE)
+    {
+      return GRAPH_NONE;
+    }
+  dynamic_push (self, x);
+  while (self->nodes[x].children[1] != GRAPH_NONE)
+    {
+      x = self->nodes[x].children[1];
+      dynamic_push (self, x);
+    }
+  dynamic_splay (self, x);
+  return x;
+}
+
+graph_vertex *mst_dynamic_parent (mst_dynamic * self, graph_vertex * root,
+                                  graph_vertex * vertex)
+{
+  if (self == NULL || root == NULL || vertex == NULL || root == vertex)
+    {
+      return NULL;
+    }
+
+  size_t r = dynamic_vertex (self, root->id);
+  size_t v = dynamic_vertex (self, vertex->id);
+  if (dynamic_find_root (self, r) != dynamic_find_root (self, v))
+    {
+      return NULL;
+    }
+
+  // The path from root to vertex alternates vertices and edges
+  dynamic_evert (self, r);
+  dynamic_access (self, v);
+  size_t edge = dynamic_predecessor (self, v);
+  size_t parent = dynamic_predecessor (self, edge);
+  return self->graph->vertices[self->nodes[parent].source];
+}
+
+int64_t mst_dynamic_apply (mst_dynamic * self, graph_vertex * source)
+{
+  if (self == NULL || source == NULL)
+    {
+      return 0;
+    }
+
+  graph_edge *tree = calloc (self->edges + 1, sizeof (graph_edge));
+  size_t count = 0;
+  for (size_t i = 0; i < self->count; ++i)
+    {
+      mst_dynamic_node *node = &self->nodes[i];
+      if (node->source != GRAPH_NONE && node->destination != GRAPH_NONE)
+        {
+          tree[count].source = node->source;
+          tree[count].destination = node->destination;
+          tree[count].weight = node->weight;
+          ++count;
+        }
+    }
+
+  int64_t total = mst_orient (self->graph, source, tree, count);
+  free (tree);
+  return total;
+}
+
+
+/* Typed weights, see mst_weight.h */
+
+#define WEIGHT_NAME i32
+#define WEIGHT_TYPE int32_t
+#include "mst_weight.h"
+
+// int32_t weights are int weights, compilation fails if they are not
+typedef char mst_i32_is_int[sizeof (int32_t) == sizeof (int) ? 1 : -1];
+
+int64_t mst_prim_csr_i32 (const graph_csr_i32 * self, size_t source,
+                          size_t * parent)
+{
+  if (self == NULL)
+    {
+      return 0;
+    }
+
+  // The same arrays seen as an int CSR graph run mst_prim_csr
+  graph_csr csr = { self->size, self->offsets, self->targets,
+    (int *) self->weights, NULL, 0
+  };
+  return mst_prim_csr (&csr, source, parent);
+}
+
+#define WEIGHT_NAME i64
+#define WEIGHT_HEAP graph_csr_i64_heap
+#define WEIGHT_TYPE int64_t
+#define WEIGHT_TOTAL int64_t
+#define WEIGHT_MAX INT64_MAX
+#define WEIGHT_MIN INT64_MIN
+#include "mst_weight.h"
+
+#define WEIGHT_NAME f32
+#define WEIGHT_HEAP graph_csr_f32_heap
+#define WEIGHT_TYPE float
+#define WEIGHT_TOTAL double
+#define WEIGHT_MAX HUGE_VALF
+#define WEIGHT_MIN (-HUGE_VALF)
+#include "mst_weight.h"
+
+#define WEIGHT_NAME f64
+#define WEIGHT_HEAP graph_csr_f64_heap
+#define WEIGHT_TYPE double
+#define WEIGHT_TOTAL double
+#define WEIGHT_MAX HUGE_VAL
+#define WEIGHT_MIN (-HUGE_VAL)
+#include "mst_weight.h"
@@ -1,15 +1,76 @@
 #ifndef MST_H
 #define MST_H
 
+#include <pthread.h>
 #include <stddef.h>
+#include <stdint.h>
+
+/* Sentinel for a missing vertex id */
+#define GRAPH_NONE SIZE_MAX
+
+/* Arena allocator */
+
+typedef struct sarena_block
+{
+  struct sarena_block *next;
+  size_t size;
+  size_t used;
+  unsigned char data[];
+} arena_block;
+
+typedef struct
+{
+  arena_block *blocks;          // most recent block first
+  size_t block_size;
+} arena;
+
+typedef struct
+{
+  arena_block *block;
+  size_t used;
+} arena_mark;
+
+/*
+ * Create an empty arena allocating blocks of block_size bytes (0 for default)
+ */
+void arena_create (arena * self, size_t block_size);
+
+/*
+ * Destroy an arena and release every allocation made from it
+ */
+void arena_destroy (arena * self);
+
+/*
+ * Allocate zeroed memory from the arena
+ */
+void *arena_alloc (arena * self, size_t size);
+
+/*
+ * Grow an allocation, in place when it is the last one of the arena
+ */
+void *arena_realloc (arena * self, void *ptr, size_t old_size, size_t size);
+
+/*
+ * Save the current state of the arena
+ */
+arena_mark arena_save (arena * self);
+
+/*
+ * Release every allocation made since a mark was saved
+ */
+void arena_restore (arena * self, arena_mark mark);
+
 
 /* Graph data structure */
 
 typedef struct sgraph_vertex
 {
+  size_t id;                    // position in graph->vertices
   size_t degree;
+  size_t capacity;              // allocated slots in neighbors and weights
   struct sgraph_vertex **neighbors;
   int *weights;
+  arena *arena;                 // owner of the storage, NULL for the heap
   // Data for MST procedure
   int distance;
   int index;                    // index in the heap queue
@@ -19,14 +80,29 @@ typedef struct sgraph_vertex
 typedef struct sgraph
 {
   size_t size;
+  size_t capacity;              // allocated slots in vertices
   graph_vertex **vertices;
+  arena *arena;                 // owner of the storage, NULL for the heap
 } graph;
 
+typedef struct
+{
+  size_t source;                // vertex ids in graph->vertices
+  size_t destination;
+  int weight;
+} graph_edge;
+
 /*
  * Create an empty graph
  */
 void graph_create (graph * self);
 
+/*
+ * Create an empty graph whose vertices and edges are stored in an arena,
+ * the graph storage is released with the arena
+ */
+void graph_create_arena (graph * self, arena * arena);
+
 /*
  * Destroy a graph
  */
@@ -43,14 +119,198 @@ graph_vertex *graph_add_vertex (graph * self);
 void graph_add_edge (graph_vertex * source, graph_vertex * destination,
                      int weight);
 
+/*
+ * Remove one edge of given weight between two vertices, the last edges of
+ * their adjacency arrays take its place, return 0 on success and -1 if there
+ * is no such edge
+ */
+int graph_remove_edge (graph_vertex * source, graph_vertex * destination,
+                       int weight);
+
+/*
+ * Change the weight of one edge between two vertices, return 0 on success
+ * and -1 if there is no such edge
+ */
+int graph_set_edge_weight (graph_vertex * source, graph_vertex * destination,
+                           int weight, int new_weight);
+
+/*
+ * Add size vertices and a list of edges between vertex ids, adjacency
+ * arrays are grown once to their exact final size
+ */
+void graph_build (graph * self, size_t size, const graph_edge * edges,
+                  size_t count);
+
+
+/*
+ * Same as graph_build with the degree counting and the adjacency filling
+ * split over threads (0 for one per online processor), the adjacency is
+ * identical to the one of graph_build, every thread needs a vertex count
+ * so no more threads than the average number of new neighbors are used
+ */
+void graph_build_parallel (graph * self, size_t size,
+                           const graph_edge * edges, size_t count,
+                           size_t threads);
+
+/*
+ * Append the edges of a text file to a graph, one "u v w" edge per line,
+ * the weight defaults to 1, lines starting with #, % or c are comments and
+ * DIMACS "p" and "a"/"e" lines are accepted with ids starting at 1, return
+ * 0 on success and -1 on error, a line that does not parse, a weight out of
+ * the int range or an id of INT_MAX or more is an error, ids are kept as
+ * they are so a file with more than 65536 vertices beyond two per edge is
+ * rejected as too sparse, the edges are buffered before graph_build and
+ * loading needs about twice the memory of the graph
+ */
+int graph_load_edges (graph * self, const char *path);
+
+
+/* Compressed sparse row graph */
+
+typedef struct
+{
+  size_t size;
+  // The neighbors of v are in [offsets[v], offsets[v + 1])
+  size_t *offsets;
+  size_t *targets;
+  int *weights;
+  void *mapping;                // read-only file mapping, NULL when allocated
+  size_t mapping_size;
+} graph_csr;
+
+/*
+ * Build a frozen CSR copy of a graph, vertex ids match graph->vertices
+ */
+void graph_csr_create (graph_csr * self, const graph * source);
+
+/*
+ * Destroy a CSR graph
+ */
+void graph_csr_destroy (graph_csr * self);
+
+/*
+ * Write a CSR graph to a binary file, return 0 on success and -1 on error
+ */
+int graph_csr_save (const graph_csr * self, const char *path);
+
+/*
+ * Write a graph to a binary file in CSR form, return 0 on success and -1 on
+ * error
+ */
+int graph_save (const graph * self, const char *path);
+
+/*
+ * Map a binary file written by graph_csr_save without copying it, the
+ * arrays are read-only, return 0 on success and -1 on error
+ */
+int graph_csr_load (graph_csr * self, const char *path);
+
+typedef enum
+{
+  GRAPH_ORDER_BFS,              // breadth-first from the smallest ids
+  GRAPH_ORDER_RCM,              // reverse Cuthill-McKee
+  GRAPH_ORDER_DEGREE            // decreasing degree
+} graph_order;
+
+/*
+ * Compute a vertex order for locality, order[new id] is the old id
+ */
+void graph_csr_order (const graph_csr * self, graph_order kind,
+                      size_t * order);
+
+/*
+ * Build a copy of a CSR graph where vertex order[i] of source becomes
+ * vertex i, with the neighbors of every vertex sorted by id
+ */
+void graph_csr_permute (graph_csr * self, const graph_csr * source,
+                        const size_t * order);
+
+/*
+ * Create a reordered copy of a graph whose vertices and adjacency arrays
+ * are allocated in the new order, vertex order[i] of source becomes vertex
+ * i, order is filled if it is not NULL, the copy is destroyed with
+ * graph_destroy
+ */
+void graph_reorder (graph * self, const graph * source, graph_order kind,
+                    size_t * order);
+
+
+/* Typed weights */
+
+/*
+ * Declare an edge type, a CSR graph type and a Prim's algorithm specialized
+ * for one weight type, totals are accumulated in total_type
+ */
+#define MST_WEIGHT_DECLARE(name, type, total_type)                        \
+  typedef struct                                                          \
+  {                                                                       \
+    size_t source;                                                        \
+    size_t destination;                                                   \
+    type weight;                                                          \
+  } graph_edge_ ## name;                                                  \
+                                                                          \
+  typedef struct                                                          \
+  {                                                                       \
+    size_t size;                                                          \
+    size_t *offsets;                                                      \
+    size_t *targets;                                                      \
+    type *weights;                                                        \
+  } graph_csr_ ## name;                                                   \
+                                                                          \
+  void graph_csr_ ## name ## _create (graph_csr_ ## name * self,          \
+                                      const graph * source);              \
+  void graph_csr_ ## name ## _build (graph_csr_ ## name * self,           \
+                                     size_t size,                         \
+                                     const graph_edge_ ## name * edges,   \
+                                     size_t count);                       \
+  void graph_csr_ ## name ## _destroy (graph_csr_ ## name * self);        \
+  total_type mst_prim_csr_ ## name (const graph_csr_ ## name * self,      \
+                                    size_t source, size_t * parent);
+
+/*
+ * graph_csr_<name>_create converts the weights of a graph,
+ * graph_csr_<name>_build builds from an edge list like graph_build and
+ * mst_prim_csr_<name> works like mst_prim_csr
+ */
+MST_WEIGHT_DECLARE (i32, int32_t, int64_t)
+MST_WEIGHT_DECLARE (i64, int64_t, int64_t)
+MST_WEIGHT_DECLARE (f32, float, double)
+MST_WEIGHT_DECLARE (f64, double, double)
+
 
 /* Queue data structure */
 
+/* Number of children of a heap node for queues created by queue_create */
+#ifndef QUEUE_ARITY
+#define QUEUE_ARITY 2
+#endif
+
+typedef enum
+{
+  QUEUE_HEAP,
+  QUEUE_PAIRING,
+  QUEUE_BUCKET
+} queue_kind;
+
 typedef struct
 {
+  queue_kind kind;
   size_t size;
+  size_t capacity;
+  size_t arity;
   int *priorities;
   graph_vertex **vertices;
+  arena *arena;
+  // Pairing heap links between slots of vertices and priorities
+  size_t *children;
+  size_t *siblings;
+  size_t *previous;
+  size_t root;
+  size_t slots;
+  // Bucket queue lists, linked through siblings and previous
+  size_t *buckets;
+  size_t bucket_count;
+  size_t cursor;
 } queue;
 
 /*
@@ -58,6 +318,30 @@ typedef struct
  */
 void queue_create (queue * self);
 
+/*
+ * Create an empty priority queue as a heap with arity children per node,
+ * an arity below 2 makes a binary heap
+ */
+void queue_create_dary (queue * self, size_t arity);
+
+/*
+ * Create an empty priority queue as a pairing heap, with constant amortized
+ * time insertion and decrease key
+ */
+void queue_create_pairing (queue * self);
+
+/*
+ * Create an empty priority queue as an array of buckets for keys between 0
+ * and max_key, with constant time insertion and decrease key, larger keys
+ * share a single bucket and so do negative keys, a negative max_key is 0
+ */
+void queue_create_bucket (queue * self, int max_key);
+
+/*
+ * Create an empty priority queue stored in an arena
+ */
+void queue_create_arena (queue * self, arena * arena);
+
 /*
  * Destroy a queue
  */
@@ -68,13 +352,19 @@ void queue_destroy (queue * self);
  */
 size_t queue_size (queue * self);
 
+/*
+ * Check whether a vertex is currently in the priority queue
+ */
+int queue_contains (queue * self, const graph_vertex * vertex);
+
 /*
  * Remove and return the vertex with minimum value in the priority queue
  */
 graph_vertex *queue_extract_min (queue * self);
 
 /*
- * Decrease the value of a vertex key at index i
+ * Decrease the value of a vertex key at index i, the index of a vertex is
+ * vertex->index, a key that is not smaller than the current one is ignored
  */
 void queue_decrease_key (queue * self, size_t i, int key);
 
@@ -86,9 +376,345 @@ void queue_insert (queue * self, graph_vertex * vertex, int key);
 
 /* Minimum Spanning Tree algorithm */
 
+typedef struct
+{
+  size_t count;                 // number of trees
+  size_t capacity;
+  graph_vertex **roots;
+  int64_t *weights;             // weight of every tree
+  int64_t total;
+} mst_forest;
+
+typedef enum
+{
+  MST_PRIM,
+  MST_KRUSKAL,
+  MST_BORUVKA,
+  MST_DENSE,
+  MST_AUTO                      // MST_DENSE or MST_PRIM by edge density
+} mst_engine;
+
+/*
+ * MST_AUTO runs the dense Prim's algorithm when the graph has at least one
+ * edge every MST_DENSE_RATIO pairs of vertices
+ */
+#ifndef MST_DENSE_RATIO
+#define MST_DENSE_RATIO 16
+#endif
+
+/*
+ * Distance between two vertices of an implicit complete graph
+ */
+typedef int (*mst_distance) (size_t source, size_t destination, void *data);
+
+/* Phases of mst_prim timed in mst_stats */
+typedef enum
+{
+  MST_PHASE_INIT,               // queue creation and vertex reset
+  MST_PHASE_FILL,               // insertion of the source
+  MST_PHASE_LOOP,               // extractions and relaxations
+  MST_PHASE_CLEANUP,            // queue destruction
+  MST_PHASE_COUNT
+} mst_phase;
+
+/*
+ * Counters of the queue operations and of Prim's algorithm, collected per
+ * thread only when the library is built with MST_STATS defined
+ */
+typedef struct
+{
+  uint64_t inserts;
+  uint64_t extractions;
+  uint64_t decrease_keys;
+  uint64_t sift_up_levels;      // heap levels crossed upwards
+  uint64_t sift_down_levels;    // heap levels crossed downwards
+  uint64_t edges_scanned;
+  uint64_t relaxations;         // edges that improved a key
+  double phases[MST_PHASE_COUNT];       // seconds spent in every phase
+} mst_stats;
+
+/*
+ * Reset the counters of the calling thread
+ */
+void mst_stats_reset (void);
+
+/*
+ * Counters of the calling thread since the last reset, all zero without
+ * MST_STATS
+ */
+mst_stats mst_stats_read (void);
+
+/*
+ * Run Prim's algorithm to set parent and return the weight of the MST of
+ * the component of source, only discovered vertices enter the queue, which
+ * is taken from the graph arena when there is one, the scratch state lives
+ * in the vertices so that concurrent runs on one graph need
+ * mst_prim_workspace instead
+ */
+int64_t mst_prim (const graph * self, graph_vertex * source);
+
+/*
+ * Run Prim's algorithm with an empty caller-created queue
+ */
+int64_t mst_prim_queue (const graph * self, graph_vertex * source, queue * q);
+
+/*
+ * Create an empty forest
+ */
+void mst_forest_create (mst_forest * self);
+
+/*
+ * Destroy a forest
+ */
+void mst_forest_destroy (mst_forest * self);
+
+/*
+ * Run Prim's algorithm on every component with a single queue, set parent
+ * (NULL for the roots), store the root and weight of every tree in forest
+ * and return the total weight
+ */
+int64_t mst_prim_forest (const graph * self, mst_forest * forest);
+
+/*
+ * Run Prim's algorithm on a CSR graph, store parent ids (GRAPH_NONE for the
+ * source and unreached vertices) if parent is not NULL and return the weight
+ */
+int64_t mst_prim_csr (const graph_csr * self, size_t source, size_t * parent);
+
+/*
+ * Scratch memory of Prim's algorithm owned by the caller, it only grows so
+ * that repeated runs on graphs of the same size do not allocate
+ */
+typedef struct
+{
+  size_t capacity;              // number of vertices the arrays can hold
+  size_t *vertices;             // heap slots
+  int *priorities;              // priorities of the heap slots
+  size_t *positions;            // heap slot of every vertex, GRAPH_NONE if out
+  int *keys;                    // lightest edge to the tree, INT_MIN once in
+  size_t *parents;              // parent ids, GRAPH_NONE for roots
+} mst_workspace;
+
+/*
+ * Create a workspace for graphs of up to size vertices
+ */
+void mst_workspace_create (mst_workspace * self, size_t size);
+
+/*
+ * Destroy a workspace
+ */
+void mst_workspace_destroy (mst_workspace * self);
+
+/*
+ * Run Prim's algorithm with all scratch state in a workspace, store parent
+ * ids in workspace->parents (GRAPH_NONE for the source and unreached
+ * vertices) and return the weight, the graph is only read so that threads
+ * with their own workspace can share it
+ */
+int64_t mst_prim_workspace (const graph * self, size_t source,
+                            mst_workspace * workspace);
+
+/*
+ * Edge filter of mst_prim_filter, return nonzero to keep the edge
+ */
+typedef int (*mst_edge_filter) (size_t source, size_t destination,
+                                int weight, void *data);
+
+/*
+ * Same as mst_prim_workspace on the subgraph of the edges kept by filter,
+ * which is called with data from the calling thread only
+ */
+int64_t mst_prim_filter (const graph * self, size_t source,
+                         mst_workspace * workspace, mst_edge_filter filter,
+                         void *data);
+
+/*
+ * Same as mst_prim_workspace on a CSR graph
+ */
+int64_t mst_prim_csr_workspace (const graph_csr * self, size_t source,
+                                mst_workspace * workspace);
+
+/*
+ * Run Prim's algorithm without a queue, every step scans the keys of all
+ * the vertices for the minimum in O(V) so that the whole run is O(V^2 + E),
+ * set parent and distance like mst_prim and return the weight
+ */
+int64_t mst_prim_dense (const graph * self, graph_vertex * source);
+
+/*
+ * Run the dense Prim's algorithm on a size x size row-major matrix of
+ * weights (INT_MAX for no edge), store parent ids (GRAPH_NONE for the
+ * source and unreached vertices) if parent is not NULL and return the weight
+ */
+int64_t mst_prim_matrix (const int *weights, size_t size, size_t source,
+                         size_t * parent);
+
+/*
+ * Same as mst_prim_matrix on the complete graph of size vertices whose
+ * weights are given by distance
+ */
+int64_t mst_prim_distance (size_t size, size_t source, mst_distance distance,
+                           void *data, size_t * parent);
+
+/*
+ * Compute the Euclidean MST of count points of the given dimension stored
+ * one after the other, store parent ids as a tree rooted at the first
+ * point (GRAPH_NONE for it) if parent is not NULL and return the length,
+ * only a k-d tree of the points is built in O(n log n) time and linear
+ * memory
+ */
+double mst_euclidean (const double *points, size_t count, size_t dimension,
+                      size_t * parent);
+
+/*
+ * Run Kruskal's algorithm, set parent as a tree rooted at source and return
+ * the weight of the MST
+ */
+int64_t mst_kruskal (const graph * self, graph_vertex * source);
+
+/*
+ * Run Boruvka's algorithm with the given number of threads (0 for one per
+ * online processor), set parent as a tree rooted at source and return the
+ * weight of the MST
+ */
+int64_t mst_boruvka (const graph * self, graph_vertex * source, size_t threads);
+
+/*
+ * Compute the MST rooted at source with the given engine
+ */
+int64_t mst_run (const graph * self, graph_vertex * source, mst_engine engine);
+
+
+/* Batch of independent Minimum Spanning Trees */
+
+typedef struct
+{
+  pthread_mutex_t lock;
+  size_t begin;                 // graphs in [begin, end) are left to solve,
+  size_t end;                   // the owner takes the first, thieves the last
+  queue queue;                  // scratch queue reused between graphs
+  struct smst_batch *batch;
+} mst_batch_worker;
+
+typedef struct smst_batch
+{
+  size_t threads;
+  pthread_t *handles;
+  mst_batch_worker *workers;    // the caller of mst_batch_run is worker 0
+  pthread_mutex_t lock;
+  pthread_cond_t start;
+  pthread_cond_t done;
+  size_t generation;            // number of batches started
+  size_t running;               // pool threads busy with the current batch
+  int stop;
+  // Current batch
+  graph *const *graphs;
+  int64_t *totals;
+  size_t **parents;
+} mst_batch;
+
+/*
+ * Create a pool of threads (0 for one per online processor) for batches
+ * of MST, the calling thread of mst_batch_run counts as one of them
+ */
+void mst_batch_create (mst_batch * self, size_t threads);
+
+/*
+ * Stop the threads of a pool and destroy it
+ */
+void mst_batch_destroy (mst_batch * self);
+
+/*
+ * Run Prim's algorithm from the first vertex of count graphs, store the
+ * weights in totals and the parent ids in parents[i] (GRAPH_NONE for the
+ * source) when they are not NULL, idle threads steal graphs from the busy
+ * ones and every thread reuses its queue from one graph to the next
+ */
+void mst_batch_run (mst_batch * self, graph * const *graphs, size_t count,
+                    int64_t * totals, size_t ** parents);
+
+
+/* Dynamic Minimum Spanning Tree */
+
+typedef struct
+{
+  size_t parent;                // splay tree parent or path parent
+  size_t children[2];
+  size_t max;                   // node of maximum weight in the splay subtree
+  size_t source;                // vertex id, GRAPH_NONE for a free node
+  size_t destination;           // GRAPH_NONE for a vertex node
+  size_t next[2];               // next tree edge around source and destination
+  int weight;
+  int reversed;
+} mst_dynamic_node;
+
+typedef struct
+{
+  graph *graph;
+  size_t count;                 // used nodes
+  size_t capacity;
+  mst_dynamic_node *nodes;      // link-cut tree over vertices and tree edges
+  size_t *stack;                // splay path, one slot per node
+  size_t *vertex_nodes;         // node of every vertex id, GRAPH_NONE if unused
+  size_t *tree_edges;           // first tree edge around every vertex id
+  size_t *marks;                // traversal stamp of every vertex id
+  size_t *queues[2];            // traversal of both sides of a cut edge
+  size_t vertex_count;
+  size_t stamp;
+  size_t free;                  // first free node, linked through parent
+  size_t edges;                 // number of tree edges
+  int64_t total;                // weight of the spanning forest
+} mst_dynamic;
+
+/*
+ * Create a dynamic spanning forest from the parent and distance of the
+ * graph vertices, as left by any MST algorithm, every later change of the
+ * graph edges must be reported to the forest
+ */
+void mst_dynamic_create (mst_dynamic * self, graph * graph);
+
+/*
+ * Destroy a dynamic spanning forest, the graph is left untouched
+ */
+void mst_dynamic_destroy (mst_dynamic * self);
+
+/*
+ * Update the forest after graph_add_edge (source, destination, weight) in
+ * amortized logarithmic time, the heaviest edge of the cycle closed by the
+ * new edge leaves the forest, return 1 if the new edge enters the forest
+ * and 0 otherwise
+ */
+int mst_dynamic_insert (mst_dynamic * self, graph_vertex * source,
+                        graph_vertex * destination, int weight);
+
+/*
+ * Update the forest after graph_remove_edge (source, destination, weight),
+ * a removed tree edge is replaced by the lightest edge between the two
+ * trees it leaves, found by scanning the edges of the smaller tree, return
+ * 1 if the forest changed and 0 otherwise
+ */
+int mst_dynamic_remove (mst_dynamic * self, graph_vertex * source,
+                        graph_vertex * destination, int weight);
+
+/*
+ * Update the forest after graph_set_edge_weight (source, destination,
+ * weight, new_weight), return 1 if the forest changed and 0 otherwise
+ */
+int mst_dynamic_update (mst_dynamic * self, graph_vertex * source,
+                        graph_vertex * destination, int weight,
+                        int new_weight);
+
+/*
+ * Parent of a vertex when its tree is rooted at root, NULL for the root and
+ * for vertices of another tree
+ */
+graph_vertex *mst_dynamic_parent (mst_dynamic * self, graph_vertex * root,
+                                  graph_vertex * vertex);
+
 /*
- * Run Prim's algorithm to set parent and return the weight of the MST
+ * Set parent and distance of the graph vertices as a tree rooted at source
+ * like mst_kruskal and return the weight of the tree containing source
  */
-int mst_prim (const graph * self, graph_vertex * source);
+int64_t mst_dynamic_apply (mst_dynamic * self, graph_vertex * source);
 
 #endif // MST_H
@@ -1,5 +1,8 @@
 #include "mst.h"
 
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <values.h>
@@ -10,13 +13,45 @@
     else { tests_pass++; } tests_run++; } while (0)
 int tests_pass, tests_run, tests_index;
 
+/*
+ * Fill a created graph with a random connected graph with distinct weights
+ */
+static void random_graph (graph * g, size_t size, size_t extra,
+                          unsigned long seed)
+{
+  size_t count = 0;
+  graph_edge *edges = calloc (size + extra, sizeof (graph_edge));
+
+  for (size_t i = 1; i < size; ++i)
+    {
+      seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+      edges[count].source = i;
+      edges[count].destination = (seed >> 33) % i;
+      ++count;
+    }
+  for (size_t i = 0; i < extra; ++i)
+    {
+      seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+      edges[count].source = (seed >> 33) % size;
+      seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+      edges[count].destination = (seed >> 33) % size;
+      ++count;
+    }
+  for (size_t i = 0; i < count; ++i)
+    {
+      edges[i].weight = (int) ((i * 7919) % 100003) + 1;
+    }
+  graph_build (g, size, edges, count);
+  free (edges);
+}
+
 static char *test_mst_dummy ()
 {
   graph g;
 
   graph_create (&g);
   graph_vertex *vertex = graph_add_vertex (&g);
-  int weight = mst_prim (&g, vertex);
+  int64_t weight = mst_prim (&g, vertex);
 
   mu_assert ("error, vertex is null", vertex != NULL);
   mu_assert ("error, minimum weight is not zero", weight == 0);
@@ -180,6 +215,325 @@ static char *test_graph_add_edge_both_sides_correct ()
   return NULL;
 }
 
+static char *test_graph_build_matches_add_edge ()
+{
+  graph *g = calloc (1, sizeof (graph));
+  graph *expected = calloc (1, sizeof (graph));
+  graph_edge edges[] = { {0, 1, 3}, {1, 2, 5}, {0, 2, 1}, {2, 3, 2},
+  {0, 1, 4}
+  };
+  size_t count = sizeof (edges) / sizeof (edges[0]);
+
+  graph_create (g);
+  graph_create (expected);
+  graph_build (g, 4, edges, count);
+  for (size_t i = 0; i < 4; ++i)
+    {
+      graph_add_vertex (expected);
+    }
+  for (size_t i = 0; i < count; ++i)
+    {
+      graph_add_edge (expected->vertices[edges[i].source],
+                      expected->vertices[edges[i].destination],
+                      edges[i].weight);
+    }
+
+  mu_assert ("error with size of built graph", g->size == 4);
+  for (size_t i = 0; i < g->size; ++i)
+    {
+      graph_vertex *v = g->vertices[i];
+      graph_vertex *e = expected->vertices[i];
+      mu_assert ("error with id of built vertex", v->id == i);
+      mu_assert ("error with degree of built vertex", v->degree == e->degree);
+      mu_assert ("error with exact capacity", v->capacity == v->degree);
+      for (size_t j = 0; j < v->degree; ++j)
+        {
+          mu_assert ("error with neighbors of built vertex",
+                     v->neighbors[j]->id == e->neighbors[j]->id
+                     && v->weights[j] == e->weights[j]);
+        }
+    }
+  mu_assert ("error with mst of built graph",
+             mst_prim (g, g->vertices[0]) == 6);
+
+  graph_destroy (g);
+  graph_destroy (expected);
+  free (g);
+  free (expected);
+  return NULL;
+}
+
+static char *test_graph_build_append ()
+{
+  graph *g = calloc (1, sizeof (graph));
+  graph_edge edges[] = { {0, 2, 1}, {1, 2, 2}, {2, 7, 3} };
+
+  graph_create (g);
+  graph_vertex *v = graph_add_vertex (g);
+  graph_build (g, 2, edges, 3);
+  graph_add_edge (v, g->vertices[1], 9);
+
+  mu_assert ("error with size of appended graph", g->size == 3);
+  mu_assert ("error, invalid edge was added", g->vertices[2]->degree == 2);
+  mu_assert ("error adding edge after build", v->degree == 2
+             && v->neighbors[1] == g->vertices[1]
+             && g->vertices[1]->degree == 2);
+
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_graph_build_parallel_matches_build ()
+{
+  graph *expected = calloc (1, sizeof (graph));
+  graph_edge *edges = calloc (5000, sizeof (graph_edge));
+
+  for (size_t i = 0; i < 5000; ++i)
+    {
+      edges[i].source = (i * 7919) % 503;
+      edges[i].destination = (i * 104729) % 499;
+      edges[i].weight = (int) i;
+    }
+  edges[10].destination = 10000;
+  graph_create (expected);
+  graph_add_vertex (expected);
+  graph_build (expected, 500, edges, 5000);
+
+  for (size_t threads = 1; threads <= 5; ++threads)
+    {
+      arena a;
+      graph *g = calloc (1, sizeof (graph));
+
+      arena_create (&a, 0);
+      if (threads == 3)
+        {
+          graph_create_arena (g, &a);
+        }
+      else
+        {
+          graph_create (g);
+        }
+      graph_add_vertex (g);
+      graph_build_parallel (g, 500, edges, 5000, threads);
+
+      mu_assert ("error with size of parallel graph",
+                 g->size == expected->size);
+      for (size_t i = 0; i < g->size; ++i)
+        {
+          graph_vertex *v = g->vertices[i];
+          graph_vertex *e = expected->vertices[i];
+          mu_assert ("error with degree of parallel graph",
+                     v->degree == e->degree);
+          for (size_t j = 0; j < v->degree; ++j)
+            {
+              mu_assert ("error with adjacency of parallel graph",
+                         v->neighbors[j]->id == e->neighbors[j]->id
+                         && v->weights[j] == e->weights[j]);
+            }
+        }
+
+      graph_destroy (g);
+      arena_destroy (&a);
+      free (g);
+    }
+
+  // Fewer edges than vertices run on a single thread
+  graph sparse;
+  graph serial;
+  graph_create (&sparse);
+  graph_create (&serial);
+  graph_build_parallel (&sparse, 5000, edges, 200, 8);
+  graph_build (&serial, 5000, edges, 200);
+  for (size_t i = 0; i < serial.size; ++i)
+    {
+      mu_assert ("error with degree of sparse parallel graph",
+                 sparse.vertices[i]->degree == serial.vertices[i]->degree);
+      for (size_t j = 0; j < serial.vertices[i]->degree; ++j)
+        {
+          mu_assert ("error with adjacency of sparse parallel graph",
+                     sparse.vertices[i]->neighbors[j]->id
+                     == serial.vertices[i]->neighbors[j]->id);
+        }
+    }
+  graph_destroy (&sparse);
+  graph_destroy (&serial);
+
+  graph_destroy (expected);
+  free (expected);
+  free (edges);
+  return NULL;
+}
+
+static char *test_graph_load_edges_snap ()
+{
+  graph *g = calloc (1, sizeof (graph));
+  const char *path = "mst_tests_snap.txt";
+  FILE *file = fopen (path, "w");
+
+  fputs ("# comment\n0 1 3\n1\t2 5\r\n\n  0 2 1\n2 3\n% other\n3 4 -2", file);
+  fclose (file);
+  graph_create (g);
+
+  mu_assert ("error loading edge list", graph_load_edges (g, path) == 0);
+  mu_assert ("error with size of loaded edge list", g->size == 5);
+  mu_assert ("error with edges of loaded edge list",
+             g->vertices[0]->degree == 2 && g->vertices[2]->degree == 3
+             && g->vertices[1]->weights[1] == 5);
+  mu_assert ("error with default weight", g->vertices[3]->weights[0] == 1);
+  mu_assert ("error with negative weight", g->vertices[4]->weights[0] == -2);
+  mu_assert ("error with mst of loaded edge list",
+             mst_prim (g, g->vertices[0]) == 3);
+  mu_assert ("error, missing file was loaded",
+             graph_load_edges (g, "mst_tests_missing.txt") == -1);
+
+  graph_destroy (g);
+  free (g);
+  remove (path);
+  return NULL;
+}
+
+static char *test_graph_load_edges_dimacs ()
+{
+  graph *g = calloc (1, sizeof (graph));
+  const char *path = "mst_tests_dimacs.txt";
+  FILE *file = fopen (path, "w");
+
+  fputs ("c dimacs\np sp 4 3\na 1 2 7\na 2 3 8\na 1 3 2\n", file);
+  fclose (file);
+  graph_create (g);
+  graph_add_vertex (g);
+
+  mu_assert ("error loading dimacs file", graph_load_edges (g, path) == 0);
+  mu_assert ("error with size of dimacs graph", g->size == 5);
+  mu_assert ("error, dimacs ids are not one based",
+             g->vertices[1]->degree == 2 && g->vertices[4]->degree == 0
+             && g->vertices[1]->neighbors[0] == g->vertices[2]);
+  mu_assert ("error with mst of dimacs graph",
+             mst_kruskal (g, g->vertices[1]) == 9);
+
+  graph_destroy (g);
+  free (g);
+  remove (path);
+  return NULL;
+}
+
+static char *test_graph_load_edges_malformed ()
+{
+  const char *path = "mst_tests_malformed.txt";
+  const char *inputs[] = { "0 1 2\n1 2 abc\n", "0 1 99999999999\n",
+    "0 1\nx 2 3\n", "0 1 2\n1 2 3 4\n", "0 4000000000\n",
+    "0 1 2\n3 99999999999999999999999\n", "p sp\na 1 2 3\n",
+    "0 1 2\n0 2000000000 1\n", "p sp 100000000 1\na 1 2 3\n"
+  };
+
+  for (size_t i = 0; i < sizeof (inputs) / sizeof (inputs[0]); ++i)
+    {
+      graph g;
+      FILE *file = fopen (path, "w");
+      fputs (inputs[i], file);
+      fclose (file);
+      graph_create (&g);
+      mu_assert ("error, malformed edge list was loaded",
+                 graph_load_edges (&g, path) == -1 && g.size == 0);
+      graph_destroy (&g);
+    }
+
+  // A sparse id within the slack is kept as it is
+  graph g;
+  FILE *file = fopen (path, "w");
+  fputs ("0 60000 4\n", file);
+  fclose (file);
+  graph_create (&g);
+  mu_assert ("error, sparse id was not loaded",
+             graph_load_edges (&g, path) == 0 && g.size == 60001
+             && g.vertices[60000]->degree == 1);
+  graph_destroy (&g);
+
+  remove (path);
+  return NULL;
+}
+
+static char *test_arena_alloc_zeroed ()
+{
+  arena a;
+
+  arena_create (&a, 64);
+  int *small = arena_alloc (&a, 4 * sizeof (int));
+  int *large = arena_alloc (&a, 100 * sizeof (int));
+
+  mu_assert ("error with arena allocation", small != NULL && large != NULL);
+  mu_assert ("error, arena memory is not zeroed", small[3] == 0
+             && large[99] == 0);
+
+  arena_mark mark = arena_save (&a);
+  int *temporary = arena_alloc (&a, 8 * sizeof (int));
+  temporary[0] = 42;
+  arena_restore (&a, mark);
+  int *again = arena_alloc (&a, 8 * sizeof (int));
+
+  mu_assert ("error, restored arena memory is not zeroed", again[0] == 0);
+
+  arena_destroy (&a);
+  mu_assert ("error destroying arena", a.blocks == NULL);
+  return NULL;
+}
+
+static char *test_graph_arena_prim ()
+{
+  arena a;
+  graph *g = calloc (1, sizeof (graph));
+  graph_edge edges[] = { {0, 1, 3}, {1, 2, 5}, {0, 2, 1}, {2, 3, 2} };
+
+  arena_create (&a, 0);
+  graph_create_arena (g, &a);
+  graph_build (g, 4, edges, 4);
+  graph_vertex *v = graph_add_vertex (g);
+  for (size_t i = 0; i < 4; ++i)
+    {
+      graph_add_edge (v, g->vertices[i], 10 + i);
+    }
+
+  mu_assert ("error with arena graph size", g->size == 5);
+  mu_assert ("error with arena graph degree", v->degree == 4
+             && g->vertices[3]->degree == 2);
+  mu_assert ("error with mst of arena graph",
+             mst_prim (g, g->vertices[0]) == 16);
+  mu_assert ("error with repeated mst of arena graph",
+             mst_prim (g, v) == 16);
+
+  graph_destroy (g);
+  arena_destroy (&a);
+  free (g);
+  return NULL;
+}
+
+static char *test_queue_arena ()
+{
+  arena a;
+  queue q;
+  graph *g = calloc (1, sizeof (graph));
+
+  arena_create (&a, 0);
+  queue_create_arena (&q, &a);
+  graph_create (g);
+
+  for (int i = 100; i > 0; --i)
+    {
+      queue_insert (&q, graph_add_vertex (g), i);
+    }
+
+  mu_assert ("error with size of arena queue", queue_size (&q) == 100);
+  mu_assert ("error extracting from arena queue",
+             queue_extract_min (&q) == g->vertices[99]);
+
+  queue_destroy (&q);
+  arena_destroy (&a);
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
 static char *test_queue_size_null ()
 {
   queue *q = NULL;
@@ -633,37 +987,1527 @@ static char *test_queue_insert_identical_weight ()
   return NULL;
 }
 
-static char *test_mst_prim_null_source ()
+static char *test_queue_contains ()
 {
+  queue *q = calloc (1, sizeof (queue));
   graph *g = calloc (1, sizeof (graph));
 
-  mu_assert ("error, minimum weight is not 0 with null source",
-             mst_prim (g, NULL) == 0);
+  queue_create (q);
+  graph_create (g);
+
+  graph_vertex *v1 = graph_add_vertex (g);
+  graph_vertex *v2 = graph_add_vertex (g);
+  graph_vertex *v3 = graph_add_vertex (g);
+  v3->index = -1;
+
+  queue_insert (q, v1, 2);
+  queue_insert (q, v2, 1);
+
+  mu_assert ("error, inserted vertices are not contained",
+             queue_contains (q, v1) && queue_contains (q, v2));
+  mu_assert ("error, vertex not inserted is contained",
+             !queue_contains (q, v3));
+  queue_extract_min (q);
+  mu_assert ("error, extracted vertex is contained", !queue_contains (q, v2)
+             && queue_contains (q, v1));
+  queue_extract_min (q);
+  mu_assert ("error, vertex of empty queue is contained",
+             !queue_contains (q, v1));
 
+  queue_destroy (q);
   graph_destroy (g);
+  free (q);
   free (g);
   return NULL;
 }
 
-static char *test_mst_prim_single_path ()
+static char *test_queue_dary_heapsort ()
 {
+  queue *q = calloc (1, sizeof (queue));
   graph *g = calloc (1, sizeof (graph));
 
-  graph_vertex *source = graph_add_vertex (g);
-  graph_vertex *v1 = graph_add_vertex (g);
-  graph_vertex *v2 = graph_add_vertex (g);
+  queue_create_dary (q, 4);
+  graph_create (g);
 
-  graph_add_edge (source, v1, 1);
-  graph_add_edge (v1, v2, 1);
+  for (int i = 0; i < 100; ++i)
+    {
+      queue_insert (q, graph_add_vertex (g), (i * 37) % 101);
+    }
+  queue_decrease_key (q, g->vertices[50]->index, -1);
 
-  mu_assert ("error, single path does not match expected",
-             mst_prim (g, source) == 2);
+  mu_assert ("error extracting decreased key from d-ary queue",
+             queue_extract_min (q) == g->vertices[50]);
+  int previous = -1;
+  while (queue_size (q) != 0)
+    {
+      graph_vertex *v = queue_extract_min (q);
+      int key = (int) ((v->id * 37) % 101);
+      mu_assert ("error, d-ary queue is not sorted", key >= previous);
+      previous = key;
+    }
+
+  queue_destroy (q);
+  graph_destroy (g);
+  free (q);
+  free (g);
+  return NULL;
+}
+
+static char *test_mst_prim_queue_dary ()
+{
+  graph *g = calloc (1, sizeof (graph));
+  queue q;
+
+  graph_create (g);
+  random_graph (g, 300, 1500, 3);
+
+  int64_t expected = mst_prim (g, g->vertices[0]);
+  queue_create_dary (&q, 4);
+
+  mu_assert ("error, d-ary prim weight does not match prim",
+             mst_prim_queue (g, g->vertices[0], &q) == expected);
+  mu_assert ("error, d-ary prim reuses queue",
+             mst_prim_queue (g, g->vertices[0], &q) == expected);
+  queue_destroy (&q);
+
+  queue_create_dary (&q, 0);
+  mu_assert ("error, arity below 2 is not clamped", q.arity == 2
+             && mst_prim_queue (g, g->vertices[0], &q) == expected);
+
+  queue_destroy (&q);
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_queue_pairing_heapsort ()
+{
+  queue *q = calloc (1, sizeof (queue));
+  graph *g = calloc (1, sizeof (graph));
+
+  queue_create_pairing (q);
+  graph_create (g);
+
+  for (int i = 0; i < 100; ++i)
+    {
+      queue_insert (q, graph_add_vertex (g), (i * 37) % 101 + 200);
+    }
+  for (int i = 0; i < 100; i += 3)
+    {
+      queue_decrease_key (q, g->vertices[i]->index, (i * 37) % 101);
+    }
+  queue_decrease_key (q, g->vertices[1]->index, 1000);
+
+  mu_assert ("error with size of pairing queue", queue_size (q) == 100);
+  int previous = -1;
+  while (queue_size (q) != 0)
+    {
+      graph_vertex *v = queue_extract_min (q);
+      int key = (int) ((v->id * 37) % 101) + (v->id % 3 == 0 ? 0 : 200);
+      mu_assert ("error, pairing queue is not sorted", key >= previous);
+      mu_assert ("error, extracted vertex is contained",
+                 !queue_contains (q, v));
+      previous = key;
+    }
+  mu_assert ("error extracting from empty pairing queue",
+             queue_extract_min (q) == NULL);
+
+  queue_destroy (q);
+  graph_destroy (g);
+  free (q);
+  free (g);
+  return NULL;
+}
+
+static char *test_mst_prim_queue_pairing ()
+{
+  graph *g = calloc (1, sizeof (graph));
+  queue q;
+
+  graph_create (g);
+  random_graph (g, 300, 3000, 4);
+
+  int64_t expected = mst_prim (g, g->vertices[0]);
+  graph_vertex **parents = calloc (g->size, sizeof (graph_vertex *));
+  for (size_t i = 0; i < g->size; ++i)
+    {
+      parents[i] = g->vertices[i]->parent;
+    }
+  queue_create_pairing (&q);
+
+  mu_assert ("error, pairing prim weight does not match prim",
+             mst_prim_queue (g, g->vertices[0], &q) == expected);
+  for (size_t i = 0; i < g->size; ++i)
+    {
+      mu_assert ("error, pairing prim parent does not match prim",
+                 g->vertices[i]->parent == parents[i]);
+    }
+
+  free (parents);
+  queue_destroy (&q);
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_queue_bucket_heapsort ()
+{
+  queue *q = calloc (1, sizeof (queue));
+  graph *g = calloc (1, sizeof (graph));
+
+  queue_create_bucket (q, 100);
+  graph_create (g);
+
+  for (int i = 0; i < 100; ++i)
+    {
+      queue_insert (q, graph_add_vertex (g), (i * 37) % 101 + 200);
+    }
+  for (int i = 0; i < 100; i += 3)
+    {
+      queue_decrease_key (q, g->vertices[i]->index, (i * 37) % 101);
+    }
+  queue_decrease_key (q, g->vertices[1]->index, 1000);
+
+  mu_assert ("error with size of bucket queue", queue_size (q) == 100);
+  int previous = -1;
+  while (queue_size (q) != 0)
+    {
+      graph_vertex *v = queue_extract_min (q);
+      int key = (int) ((v->id * 37) % 101) + (v->id % 3 == 0 ? 0 : 200);
+      mu_assert ("error, bucket queue is not sorted", key >= previous);
+      mu_assert ("error, extracted vertex is contained",
+                 !queue_contains (q, v));
+      previous = key;
+    }
 
+  queue_destroy (q);
   graph_destroy (g);
+  free (q);
   free (g);
   return NULL;
 }
 
+static char *test_queue_bucket_negative ()
+{
+  queue q;
+  graph g;
+  int keys[] = { 3, -7, 0, 12, -1, 5, -7, 2 };
+
+  // A negative max_key still makes a valid queue
+  queue_create_bucket (&q, -4);
+  graph_create (&g);
+  for (size_t i = 0; i < 8; ++i)
+    {
+      queue_insert (&q, graph_add_vertex (&g), keys[i]);
+    }
+  queue_decrease_key (&q, g.vertices[3]->index, -20);
+  keys[3] = -20;
+
+  int previous = INT_MIN;
+  while (queue_size (&q) != 0)
+    {
+      graph_vertex *v = queue_extract_min (&q);
+      mu_assert ("error, negative keys are not sorted",
+                 keys[v->id] >= previous);
+      previous = keys[v->id];
+    }
+  mu_assert ("error, last key is not the largest", previous == 5);
+
+  queue_destroy (&q);
+  graph_destroy (&g);
+  return NULL;
+}
+
+static char *test_mst_prim_queue_bucket ()
+{
+  graph *g = calloc (1, sizeof (graph));
+  graph_edge *edges = calloc (3000, sizeof (graph_edge));
+  queue q;
+
+  graph_create (g);
+  for (size_t i = 0; i < 3000; ++i)
+    {
+      edges[i].source = i % 300;
+      edges[i].destination = i < 300 ? (i + 1) % 300 : (i * 7) % 300;
+      edges[i].weight = (int) ((i * 13) % 50);
+    }
+  graph_build (g, 300, edges, 3000);
+
+  int64_t expected = mst_prim (g, g->vertices[0]);
+  queue_create_bucket (&q, 49);
+
+  mu_assert ("error, bucket prim weight does not match prim",
+             mst_prim_queue (g, g->vertices[0], &q) == expected);
+  mu_assert ("error, bucket prim weight does not match kruskal",
+             mst_kruskal (g, g->vertices[0]) == expected);
+
+  queue_destroy (&q);
+  graph_destroy (g);
+  free (edges);
+  free (g);
+  return NULL;
+}
+
+static char *test_mst_prim_null_source ()
+{
+  graph *g = calloc (1, sizeof (graph));
+
+  mu_assert ("error, minimum weight is not 0 with null source",
+             mst_prim (g, NULL) == 0);
+
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_mst_prim_single_path ()
+{
+  graph *g = calloc (1, sizeof (graph));
+
+  graph_vertex *source = graph_add_vertex (g);
+  graph_vertex *v1 = graph_add_vertex (g);
+  graph_vertex *v2 = graph_add_vertex (g);
+
+  graph_add_edge (source, v1, 1);
+  graph_add_edge (v1, v2, 1);
+
+  mu_assert ("error, single path does not match expected",
+             mst_prim (g, source) == 2);
+
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_graph_csr_create ()
+{
+  graph *g = calloc (1, sizeof (graph));
+  graph_csr csr;
+
+  graph_create (g);
+  graph_vertex *v1 = graph_add_vertex (g);
+  graph_vertex *v2 = graph_add_vertex (g);
+  graph_vertex *v3 = graph_add_vertex (g);
+
+  graph_add_edge (v1, v2, 4);
+  graph_add_edge (v1, v3, 7);
+
+  graph_csr_create (&csr, g);
+
+  mu_assert ("error with csr size", csr.size == 3);
+  mu_assert ("error with csr offsets", csr.offsets[0] == 0
+             && csr.offsets[1] == 2 && csr.offsets[2] == 3
+             && csr.offsets[3] == 4);
+  mu_assert ("error with csr targets", csr.targets[0] == v2->id
+             && csr.targets[1] == v3->id && csr.targets[2] == v1->id
+             && csr.targets[3] == v1->id);
+  mu_assert ("error with csr weights", csr.weights[0] == 4
+             && csr.weights[1] == 7 && csr.weights[2] == 4
+             && csr.weights[3] == 7);
+
+  graph_csr_destroy (&csr);
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_mst_prim_csr_matches_prim ()
+{
+  graph *g = calloc (1, sizeof (graph));
+  graph_csr csr;
+  size_t parent[6];
+
+  graph_create (g);
+  graph_vertex *v[6];
+  for (size_t i = 0; i < 6; ++i)
+    {
+      v[i] = graph_add_vertex (g);
+    }
+  graph_add_edge (v[0], v[1], 7);
+  graph_add_edge (v[0], v[3], 5);
+  graph_add_edge (v[1], v[2], 8);
+  graph_add_edge (v[1], v[3], 9);
+  graph_add_edge (v[1], v[4], 6);
+  graph_add_edge (v[2], v[4], 4);
+  graph_add_edge (v[3], v[4], 15);
+  graph_add_edge (v[3], v[5], 3);
+  graph_add_edge (v[4], v[5], 11);
+
+  int64_t expected = mst_prim (g, v[0]);
+  graph_csr_create (&csr, g);
+
+  mu_assert ("error, csr weight does not match prim",
+             mst_prim_csr (&csr, 0, parent) == expected && expected == 25);
+  mu_assert ("error, csr source has a parent", parent[0] == GRAPH_NONE);
+  for (size_t i = 1; i < 6; ++i)
+    {
+      mu_assert ("error, csr parent does not match prim",
+                 parent[i] == v[i]->parent->id);
+    }
+
+  graph_csr_destroy (&csr);
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_graph_csr_isolated ()
+{
+  graph g;
+  graph_csr csr;
+  graph_edge edges[] = { {0, 2, 5} };
+
+  graph_create (&g);
+  graph_build (&g, 4, edges, 1);
+  graph_csr_create (&csr, &g);
+
+  mu_assert ("error with offsets of isolated vertices",
+             csr.offsets[1] == 1 && csr.offsets[2] == 1
+             && csr.offsets[3] == 2 && csr.offsets[4] == 2);
+  mu_assert ("error with weights next to isolated vertices",
+             csr.weights[0] == 5 && csr.weights[1] == 5);
+
+  graph_csr_destroy (&csr);
+  graph_destroy (&g);
+  return NULL;
+}
+
+static char *test_graph_csr_save_load ()
+{
+  graph *g = calloc (1, sizeof (graph));
+  graph_csr csr;
+  graph_csr mapped;
+  const char *path = "mst_tests_graph.bin";
+
+  graph_create (g);
+  random_graph (g, 100, 300, 5);
+  graph_csr_create (&csr, g);
+
+  mu_assert ("error saving graph", graph_save (g, path) == 0);
+  mu_assert ("error loading graph", graph_csr_load (&mapped, path) == 0);
+  mu_assert ("error with size of loaded graph", mapped.size == csr.size
+             && mapped.mapping != NULL);
+  for (size_t i = 0; i <= csr.size; ++i)
+    {
+      mu_assert ("error with offsets of loaded graph",
+                 mapped.offsets[i] == csr.offsets[i]);
+    }
+  for (size_t i = 0; i < csr.offsets[csr.size]; ++i)
+    {
+      mu_assert ("error with edges of loaded graph",
+                 mapped.targets[i] == csr.targets[i]
+                 && mapped.weights[i] == csr.weights[i]);
+    }
+  mu_assert ("error with mst of loaded graph",
+             mst_prim_csr (&mapped, 0, NULL) == mst_prim (g, g->vertices[0]));
+
+  graph_csr_destroy (&mapped);
+  graph_csr_destroy (&csr);
+  graph_destroy (g);
+  free (g);
+  remove (path);
+  return NULL;
+}
+
+static char *test_graph_csr_load_invalid ()
+{
+  graph_csr csr;
+  const char *path = "mst_tests_invalid.bin";
+  FILE *file = fopen (path, "wb");
+
+  fputs ("not a graph file, but long enough to hold a header", file);
+  fclose (file);
+
+  mu_assert ("error, invalid file was loaded",
+             graph_csr_load (&csr, path) == -1);
+
+  // Well-formed files whose arrays do not describe a graph
+  size_t offsets[][4] = { {0, 2, 1, 2}, {0, 1, 2, 2} };
+  size_t targets[][2] = { {1, 0}, {1, 3} };
+  int weights[] = { 1, 1 };
+  for (size_t i = 0; i < 2; ++i)
+    {
+      graph_csr bad = { 3, offsets[i], targets[i], weights, NULL, 0 };
+      mu_assert ("error saving graph", graph_csr_save (&bad, path) == 0);
+      mu_assert ("error, inconsistent file was loaded",
+                 graph_csr_load (&csr, path) == -1);
+    }
+  mu_assert ("error, missing file was loaded",
+             graph_csr_load (&csr, "mst_tests_missing.bin") == -1);
+
+  remove (path);
+  return NULL;
+}
+
+static char *test_mst_prim_csr_typed_matches_prim ()
+{
+  graph *g = calloc (1, sizeof (graph));
+  graph_csr_i32 csr32;
+  graph_csr_i64 csr64;
+  graph_csr_f32 csrf;
+  graph_csr_f64 csrd;
+
+  graph_create (g);
+  random_graph (g, 200, 800, 6);
+  int64_t expected = mst_prim (g, g->vertices[0]);
+  graph_csr_i32_create (&csr32, g);
+  graph_csr_i64_create (&csr64, g);
+  graph_csr_f32_create (&csrf, g);
+  graph_csr_f64_create (&csrd, g);
+
+  size_t *parent = calloc (g->size, sizeof (size_t));
+  mu_assert ("error, int32 weight does not match prim",
+             mst_prim_csr_i32 (&csr32, 0, parent) == expected);
+  for (size_t i = 1; i < g->size; ++i)
+    {
+      mu_assert ("error, int32 parent does not match prim",
+                 parent[i] == g->vertices[i]->parent->id);
+    }
+  mu_assert ("error, int64 weight does not match prim",
+             mst_prim_csr_i64 (&csr64, 0, NULL) == expected);
+  mu_assert ("error, float weight does not match prim",
+             mst_prim_csr_f32 (&csrf, 0, NULL) == (double) expected);
+  mu_assert ("error, double weight does not match prim",
+             mst_prim_csr_f64 (&csrd, 0, NULL) == (double) expected);
+
+  free (parent);
+  graph_csr_i32_destroy (&csr32);
+  graph_csr_i64_destroy (&csr64);
+  graph_csr_f32_destroy (&csrf);
+  graph_csr_f64_destroy (&csrd);
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_mst_prim_csr_typed_wide ()
+{
+  graph_csr_i32 csr32;
+  graph_csr_f64 csrd;
+  graph_edge_i32 edges32[] = { {0, 1, 2000000000}, {1, 2, 2000000000},
+  {0, 2, 2100000000}, {2, 3, 2000000000}
+  };
+  graph_edge_f64 edgesd[] = { {0, 1, 0.25}, {1, 2, 1.5}, {0, 2, 0.5},
+  {2, 3, 0.125}
+  };
+  size_t parent[4];
+
+  graph_csr_i32_build (&csr32, 4, edges32, 4);
+  graph_csr_f64_build (&csrd, 4, edgesd, 4);
+
+  mu_assert ("error, int32 total is not accumulated in 64 bits",
+             mst_prim_csr_i32 (&csr32, 0, NULL) == 6000000000LL);
+  mu_assert ("error, double total does not match",
+             mst_prim_csr_f64 (&csrd, 3, parent) == 0.875);
+  mu_assert ("error, double parents do not match", parent[3] == GRAPH_NONE
+             && parent[2] == 3 && parent[0] == 2 && parent[1] == 0);
+
+  graph_csr_i32_destroy (&csr32);
+  graph_csr_f64_destroy (&csrd);
+  return NULL;
+}
+
+static char *test_mst_kruskal_matches_prim ()
+{
+  graph *g = calloc (1, sizeof (graph));
+
+  graph_create (g);
+  random_graph (g, 200, 1000, 1);
+
+  int64_t expected = mst_prim (g, g->vertices[0]);
+  graph_vertex **parents = calloc (g->size, sizeof (graph_vertex *));
+  for (size_t i = 0; i < g->size; ++i)
+    {
+      parents[i] = g->vertices[i]->parent;
+    }
+
+  mu_assert ("error, kruskal weight does not match prim",
+             mst_kruskal (g, g->vertices[0]) == expected);
+  for (size_t i = 0; i < g->size; ++i)
+    {
+      mu_assert ("error, kruskal parent does not match prim",
+                 g->vertices[i]->parent == parents[i]);
+    }
+  mu_assert ("error running kruskal engine",
+             mst_run (g, g->vertices[0], MST_KRUSKAL) == expected);
+  mu_assert ("error running prim engine",
+             mst_run (g, g->vertices[0], MST_PRIM) == expected);
+
+  free (parents);
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_mst_kruskal_null_source ()
+{
+  graph *g = calloc (1, sizeof (graph));
+
+  mu_assert ("error, minimum weight is not 0 with null source",
+             mst_kruskal (g, NULL) == 0);
+
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_mst_boruvka_matches_prim ()
+{
+  graph *g = calloc (1, sizeof (graph));
+
+  graph_create (g);
+  random_graph (g, 500, 2000, 2);
+
+  int64_t expected = mst_prim (g, g->vertices[7]);
+  graph_vertex **parents = calloc (g->size, sizeof (graph_vertex *));
+  for (size_t i = 0; i < g->size; ++i)
+    {
+      parents[i] = g->vertices[i]->parent;
+    }
+
+  for (size_t threads = 1; threads <= 4; ++threads)
+    {
+      mu_assert ("error, boruvka weight does not match prim",
+                 mst_boruvka (g, g->vertices[7], threads) == expected);
+      for (size_t i = 0; i < g->size; ++i)
+        {
+          mu_assert ("error, boruvka parent does not match prim",
+                     g->vertices[i]->parent == parents[i]);
+        }
+    }
+  mu_assert ("error running boruvka engine",
+             mst_run (g, g->vertices[7], MST_BORUVKA) == expected);
+
+  free (parents);
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_mst_boruvka_disconnected ()
+{
+  graph *g = calloc (1, sizeof (graph));
+  graph_edge edges[] = { {0, 1, 4}, {1, 2, 1}, {0, 2, 2}, {3, 4, 8} };
+
+  graph_create (g);
+  graph_build (g, 5, edges, 4);
+
+  mu_assert ("error, boruvka weight of source component",
+             mst_boruvka (g, g->vertices[0], 2) == 3);
+  mu_assert ("error, boruvka reached another component",
+             g->vertices[3]->parent == NULL
+             && g->vertices[4]->parent == NULL);
+
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_mst_prim_disconnected ()
+{
+  graph *g = calloc (1, sizeof (graph));
+  graph_edge edges[] = { {0, 1, 4}, {1, 2, 1}, {0, 2, 2}, {3, 4, 8} };
+
+  graph_create (g);
+  graph_build (g, 5, edges, 4);
+
+  mu_assert ("error, prim weight of disconnected graph",
+             mst_prim (g, g->vertices[4]) == 8);
+  mu_assert ("error, prim reached another component",
+             g->vertices[0]->distance == INT_MAX
+             && g->vertices[0]->parent == NULL);
+
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_mst_prim_wide_total ()
+{
+  graph *g = calloc (1, sizeof (graph));
+  graph_csr csr;
+  graph_edge edges[] = { {0, 1, 2000000000}, {1, 2, 2000000000},
+  {0, 2, 2100000000}
+  };
+
+  graph_create (g);
+  graph_build (g, 3, edges, 3);
+  graph_csr_create (&csr, g);
+
+  mu_assert ("error, prim total overflows",
+             mst_prim (g, g->vertices[0]) == 4000000000LL);
+  mu_assert ("error, csr total overflows",
+             mst_prim_csr (&csr, 0, NULL) == 4000000000LL);
+  mu_assert ("error, engine totals overflow",
+             mst_run (g, g->vertices[0], MST_KRUSKAL) == 4000000000LL
+             && mst_run (g, g->vertices[0], MST_BORUVKA) == 4000000000LL
+             && mst_run (g, g->vertices[0], MST_DENSE) == 4000000000LL);
+
+  graph_csr_destroy (&csr);
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_mst_prim_forest ()
+{
+  graph *g = calloc (1, sizeof (graph));
+  mst_forest forest;
+  graph_edge edges[] = { {0, 1, 2000000000}, {1, 2, 2000000000},
+  {0, 2, 2100000000}, {3, 4, 2000000000}, {5, 6, 3}, {6, 7, 4},
+  {5, 7, 1}
+  };
+
+  graph_create (g);
+  graph_build (g, 9, edges, 7);
+  mst_forest_create (&forest);
+
+  mu_assert ("error with total weight of forest",
+             mst_prim_forest (g, &forest) == 6000000004LL);
+  mu_assert ("error with number of trees", forest.count == 4);
+  mu_assert ("error with roots of forest", forest.roots[0] == g->vertices[0]
+             && forest.roots[1] == g->vertices[3]
+             && forest.roots[2] == g->vertices[5]
+             && forest.roots[3] == g->vertices[8]);
+  mu_assert ("error with weights of forest",
+             forest.weights[0] == 4000000000LL
+             && forest.weights[1] == 2000000000LL && forest.weights[2] == 4
+             && forest.weights[3] == 0);
+  mu_assert ("error with parents of forest",
+             g->vertices[2]->parent == g->vertices[1]
+             && g->vertices[7]->parent == g->vertices[5]
+             && g->vertices[8]->parent == NULL);
+  mu_assert ("error reusing forest", mst_prim_forest (g, &forest)
+             == forest.total && forest.count == 4);
+
+  mst_forest_destroy (&forest);
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_mst_dynamic_insert ()
+{
+  graph *g = calloc (1, sizeof (graph));
+  mst_dynamic dynamic;
+  unsigned long seed = 11;
+
+  graph_create (g);
+  random_graph (g, 200, 400, 5);
+  mst_prim (g, g->vertices[0]);
+  mst_dynamic_create (&dynamic, g);
+  mu_assert ("error, forest weight does not match prim",
+             dynamic.total == mst_prim (g, g->vertices[0]));
+
+  for (size_t i = 0; i < 300; ++i)
+    {
+      seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+      graph_vertex *u = g->vertices[(seed >> 33) % g->size];
+      seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+      graph_vertex *v = g->vertices[(seed >> 33) % g->size];
+      seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+      int weight = (int) ((seed >> 33) % 100003) + 1;
+      graph_add_edge (u, v, weight);
+      mst_dynamic_insert (&dynamic, u, v, weight);
+      if (i % 30 == 0)
+        {
+          mu_assert ("error, forest weight does not match prim after insert",
+                     dynamic.total == mst_prim (g, g->vertices[0]));
+        }
+    }
+
+  mu_assert ("error, applied weight does not match prim",
+             mst_dynamic_apply (&dynamic, g->vertices[3])
+             == mst_prim (g, g->vertices[0]));
+  mst_dynamic_apply (&dynamic, g->vertices[3]);
+  for (size_t i = 0; i < g->size; ++i)
+    {
+      mu_assert ("error, parent query does not match applied parent",
+                 mst_dynamic_parent (&dynamic, g->vertices[3], g->vertices[i])
+                 == g->vertices[i]->parent);
+    }
+
+  mst_dynamic_destroy (&dynamic);
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_mst_dynamic_link ()
+{
+  graph g;
+  mst_dynamic dynamic;
+
+  graph_create (&g);
+  graph_vertex *a = graph_add_vertex (&g);
+  graph_vertex *b = graph_add_vertex (&g);
+  mst_prim (&g, a);
+  mst_dynamic_create (&dynamic, &g);
+
+  graph_add_edge (a, b, 5);
+  mu_assert ("error, edge between trees is not linked",
+             mst_dynamic_insert (&dynamic, a, b, 5) == 1
+             && dynamic.total == 5);
+  graph_add_edge (a, b, 3);
+  mu_assert ("error, lighter parallel edge is not swapped",
+             mst_dynamic_insert (&dynamic, a, b, 3) == 1
+             && dynamic.total == 3);
+  graph_add_edge (a, b, 7);
+  mu_assert ("error, heavier parallel edge enters the forest",
+             mst_dynamic_insert (&dynamic, a, b, 7) == 0
+             && dynamic.total == 3);
+
+  graph_vertex *c = graph_add_vertex (&g);
+  graph_add_edge (b, c, 4);
+  mu_assert ("error, new vertex is not linked",
+             mst_dynamic_insert (&dynamic, c, b, 4) == 1
+             && dynamic.total == 7);
+  mu_assert ("error, parent of new vertex is wrong",
+             mst_dynamic_parent (&dynamic, a, c) == b
+             && mst_dynamic_parent (&dynamic, a, a) == NULL);
+  mu_assert ("error, applied weight is wrong",
+             mst_dynamic_apply (&dynamic, c) == 7 && a->parent == b
+             && b->parent == c && c->parent == NULL);
+
+  mst_dynamic_destroy (&dynamic);
+  graph_destroy (&g);
+  return NULL;
+}
+
+static char *test_graph_remove_edge ()
+{
+  graph g;
+
+  graph_create (&g);
+  graph_vertex *a = graph_add_vertex (&g);
+  graph_vertex *b = graph_add_vertex (&g);
+  graph_vertex *c = graph_add_vertex (&g);
+  graph_add_edge (a, b, 1);
+  graph_add_edge (a, c, 2);
+  graph_add_edge (a, b, 3);
+
+  mu_assert ("error, missing edge is removed",
+             graph_remove_edge (a, b, 2) == -1 && a->degree == 3);
+  mu_assert ("error, edge is not removed",
+             graph_remove_edge (b, a, 1) == 0 && a->degree == 2
+             && b->degree == 1 && b->weights[0] == 3);
+  mu_assert ("error, weight is not changed",
+             graph_set_edge_weight (a, c, 2, 5) == 0 && c->weights[0] == 5
+             && graph_set_edge_weight (a, c, 2, 5) == -1);
+  mu_assert ("error, minimum weight is wrong", mst_prim (&g, a) == 8);
+
+  graph_destroy (&g);
+  return NULL;
+}
+
+static char *test_mst_dynamic_remove ()
+{
+  graph *g = calloc (1, sizeof (graph));
+  mst_dynamic dynamic;
+  mst_forest forest;
+  unsigned long seed = 17;
+
+  graph_create (g);
+  random_graph (g, 150, 300, 8);
+  mst_prim (g, g->vertices[0]);
+  mst_dynamic_create (&dynamic, g);
+  mst_forest_create (&forest);
+
+  for (size_t i = 0; i < 600; ++i)
+    {
+      seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+      graph_vertex *u = g->vertices[(seed >> 33) % g->size];
+      seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+      int weight = (int) ((seed >> 33) % 100003) + 1;
+      if (u->degree == 0)
+        {
+          continue;
+        }
+      size_t j = (seed >> 40) % u->degree;
+      graph_vertex *v = u->neighbors[j];
+      int old = u->weights[j];
+      switch (i % 3)
+        {
+        case 0:
+          graph_remove_edge (u, v, old);
+          mst_dynamic_remove (&dynamic, u, v, old);
+          break;
+        case 1:
+          graph_set_edge_weight (u, v, old, weight);
+          mst_dynamic_update (&dynamic, u, v, old, weight);
+          break;
+        default:
+          v = g->vertices[(seed >> 20) % g->size];
+          graph_add_edge (u, v, weight);
+          mst_dynamic_insert (&dynamic, u, v, weight);
+          break;
+        }
+      mu_assert ("error, forest weight does not match prim",
+                 dynamic.total == mst_prim_forest (g, &forest));
+    }
+
+  mst_forest_destroy (&forest);
+  mst_dynamic_destroy (&dynamic);
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_mst_dynamic_loop ()
+{
+  graph g;
+  mst_dynamic dynamic;
+  graph_edge edges[] = { {0, 1, 0}, {1, 2, 1}, {2, 2, 1}, {2, 3, 3},
+  {2, 4, 0}
+  };
+
+  graph_create (&g);
+  graph_build (&g, 5, edges, 5);
+  mst_prim (&g, g.vertices[0]);
+  mst_dynamic_create (&dynamic, &g);
+  graph_vertex *v = g.vertices[2];
+
+  graph_set_edge_weight (v, v, 1, 0);
+  mu_assert ("error, loop update changes the forest",
+             mst_dynamic_update (&dynamic, v, v, 1, 0) == 0
+             && dynamic.total == 4);
+  graph_remove_edge (v, v, 0);
+  mu_assert ("error, loop removal changes the forest",
+             mst_dynamic_remove (&dynamic, v, v, 0) == 0
+             && dynamic.total == 4);
+  mu_assert ("error, forest weight does not match prim",
+             dynamic.total == mst_prim (&g, g.vertices[0]));
+
+  mst_dynamic_destroy (&dynamic);
+  graph_destroy (&g);
+  return NULL;
+}
+
+static char *test_mst_batch ()
+{
+  size_t count = 120;
+  graph **graphs = calloc (count, sizeof (graph *));
+  size_t **parents = calloc (count, sizeof (size_t *));
+  int64_t *totals = calloc (count, sizeof (int64_t));
+  mst_batch batch;
+
+  for (size_t i = 0; i < count; ++i)
+    {
+      graphs[i] = calloc (1, sizeof (graph));
+      graph_create (graphs[i]);
+      random_graph (graphs[i], 2 + (i * 37) % 90, (i * 53) % 200, i);
+      parents[i] = calloc (graphs[i]->size, sizeof (size_t));
+    }
+
+  mst_batch_create (&batch, 4);
+  for (int round = 0; round < 2; ++round)
+    {
+      mst_batch_run (&batch, graphs, count, totals, parents);
+      for (size_t i = 0; i < count; ++i)
+        {
+          graph *g = graphs[i];
+          mu_assert ("error, batch weight does not match prim",
+                     totals[i] == mst_prim (g, g->vertices[0]));
+          for (size_t j = 1; j < g->size; ++j)
+            {
+              mu_assert ("error, batch parent does not match prim",
+                         parents[i][j] == g->vertices[j]->parent->id);
+            }
+          mu_assert ("error, batch source has a parent",
+                     parents[i][0] == GRAPH_NONE);
+        }
+    }
+  mst_batch_destroy (&batch);
+
+  for (size_t i = 0; i < count; ++i)
+    {
+      graph_destroy (graphs[i]);
+      free (graphs[i]);
+      free (parents[i]);
+    }
+  free (graphs);
+  free (parents);
+  free (totals);
+  return NULL;
+}
+
+static char *test_mst_prim_workspace ()
+{
+  graph *g = calloc (1, sizeof (graph));
+  graph_csr csr;
+  mst_workspace workspace;
+
+  graph_create (g);
+  random_graph (g, 250, 900, 9);
+  graph_csr_create (&csr, g);
+  mst_workspace_create (&workspace, 10);
+
+  for (size_t source = 0; source < g->size; source += 50)
+    {
+      int64_t expected = mst_prim (g, g->vertices[source]);
+      for (size_t i = 0; i < g->size; ++i)
+        {
+          g->vertices[i]->index = -2;
+        }
+      mu_assert ("error, workspace weight does not match prim",
+                 mst_prim_workspace (g, source, &workspace) == expected);
+      for (size_t i = 0; i < g->size; ++i)
+        {
+          graph_vertex *parent = g->vertices[i]->parent;
+          mu_assert ("error, workspace parent does not match prim",
+                     workspace.parents[i] ==
+                     (parent != NULL ? parent->id : GRAPH_NONE));
+          mu_assert ("error, workspace writes to the graph",
+                     g->vertices[i]->index == -2);
+        }
+      mu_assert ("error, CSR workspace weight does not match prim",
+                 mst_prim_csr_workspace (&csr, source, &workspace)
+                 == expected);
+    }
+
+  // Re-weighted graphs reuse the grown workspace
+  size_t *vertices = workspace.vertices;
+  graph_vertex *u = g->vertices[7];
+  graph_set_edge_weight (u, u->neighbors[0], u->weights[0], -5);
+  mu_assert ("error, re-weighted workspace weight does not match prim",
+             mst_prim_workspace (g, 0, &workspace) ==
+             mst_prim (g, g->vertices[0]) && workspace.vertices == vertices);
+
+  mst_workspace_destroy (&workspace);
+  graph_csr_destroy (&csr);
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+typedef struct
+{
+  const graph *graph;
+  size_t source;
+  int limit;
+  int64_t total;
+  size_t *parents;
+} filter_task;
+
+static int filter_below (size_t source, size_t destination, int weight,
+                         void *data)
+{
+  (void) source;
+  (void) destination;
+  return weight <= *(const int *) data;
+}
+
+static void *filter_run (void *data)
+{
+  filter_task *task = data;
+  mst_workspace workspace;
+
+  mst_workspace_create (&workspace, task->graph->size);
+  for (int round = 0; round < 20; ++round)
+    {
+      task->total = mst_prim_filter (task->graph, task->source, &workspace,
+                                     filter_below, &task->limit);
+    }
+  for (size_t i = 0; i < task->graph->size; ++i)
+    {
+      task->parents[i] = workspace.parents[i];
+    }
+  mst_workspace_destroy (&workspace);
+  return NULL;
+}
+
+static char *test_mst_prim_filter_threads ()
+{
+  graph *g = calloc (1, sizeof (graph));
+  filter_task tasks[4];
+  pthread_t threads[4];
+  mst_workspace workspace;
+
+  graph_create (g);
+  random_graph (g, 300, 1200, 10);
+  for (size_t t = 0; t < 4; ++t)
+    {
+      tasks[t].graph = g;
+      tasks[t].source = 40 * t;
+      tasks[t].limit = t == 0 ? INT_MAX : 100003 / (int) (t + 1);
+      tasks[t].parents = calloc (g->size, sizeof (size_t));
+      pthread_create (&threads[t], NULL, filter_run, &tasks[t]);
+    }
+  for (size_t t = 0; t < 4; ++t)
+    {
+      pthread_join (threads[t], NULL);
+    }
+
+  mst_workspace_create (&workspace, 0);
+  mu_assert ("error, unfiltered weight does not match prim",
+             tasks[0].total == mst_prim (g, g->vertices[0]));
+  for (size_t t = 0; t < 4; ++t)
+    {
+      mu_assert ("error, concurrent weight does not match serial run",
+                 tasks[t].total == mst_prim_filter (g, tasks[t].source,
+                                                    &workspace, filter_below,
+                                                    &tasks[t].limit));
+      for (size_t i = 0; i < g->size; ++i)
+        {
+          mu_assert ("error, concurrent parent does not match serial run",
+                     tasks[t].parents[i] == workspace.parents[i]);
+        }
+    }
+
+  // The filter gives the MST of the subgraph of the kept edges
+  graph sub;
+  graph_create (&sub);
+  for (size_t i = 0; i < g->size; ++i)
+    {
+      graph_add_vertex (&sub);
+    }
+  for (size_t i = 0; i < g->size; ++i)
+    {
+      graph_vertex *u = g->vertices[i];
+      for (size_t j = 0; j < u->degree; ++j)
+        {
+          if (u->id < u->neighbors[j]->id && u->weights[j] <= tasks[3].limit)
+            {
+              graph_add_edge (sub.vertices[u->id],
+                              sub.vertices[u->neighbors[j]->id],
+                              u->weights[j]);
+            }
+        }
+    }
+  mu_assert ("error, filtered weight does not match subgraph",
+             tasks[3].total == mst_prim (&sub, sub.vertices[120]));
+
+  for (size_t t = 0; t < 4; ++t)
+    {
+      free (tasks[t].parents);
+    }
+  mst_workspace_destroy (&workspace);
+  graph_destroy (&sub);
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_mst_prim_csr_hubs ()
+{
+  graph g;
+  graph_csr csr;
+  size_t count = 0;
+  graph_edge *edges = calloc (2000, sizeof (graph_edge));
+
+  // Hubs of high degree with repeated targets inside a block of edges
+  for (size_t hub = 0; hub < 4; ++hub)
+    {
+      for (size_t i = 4; i < 300; ++i)
+        {
+          edges[count].source = hub;
+          edges[count].destination = i - (i % 3 == 0 && hub != 0);
+          edges[count].weight = (int) ((count * 7919) % 10007) + 1;
+          ++count;
+        }
+    }
+  graph_create (&g);
+  graph_build (&g, 300, edges, count);
+  graph_csr_create (&csr, &g);
+
+  size_t *parent = calloc (g.size, sizeof (size_t));
+  mu_assert ("error, CSR weight does not match prim on hubs",
+             mst_prim_csr (&csr, 5, parent) == mst_prim (&g, g.vertices[5]));
+  for (size_t i = 0; i < g.size; ++i)
+    {
+      graph_vertex *p = g.vertices[i]->parent;
+      mu_assert ("error, CSR parent does not match prim on hubs",
+                 parent[i] == (p != NULL ? p->id : GRAPH_NONE));
+    }
+
+  free (parent);
+  free (edges);
+  graph_csr_destroy (&csr);
+  graph_destroy (&g);
+  return NULL;
+}
+
+static char *test_mst_prim_dense ()
+{
+  graph *g = calloc (1, sizeof (graph));
+
+  graph_create (g);
+  random_graph (g, 120, 3000, 12);
+  int64_t expected = mst_prim (g, g->vertices[4]);
+  graph_vertex **parents = calloc (g->size, sizeof (graph_vertex *));
+  int *distances = calloc (g->size, sizeof (int));
+  for (size_t i = 0; i < g->size; ++i)
+    {
+      parents[i] = g->vertices[i]->parent;
+      distances[i] = g->vertices[i]->distance;
+    }
+
+  mu_assert ("error, dense weight does not match prim",
+             mst_prim_dense (g, g->vertices[4]) == expected);
+  for (size_t i = 0; i < g->size; ++i)
+    {
+      mu_assert ("error, dense parent does not match prim",
+                 g->vertices[i]->parent == parents[i]
+                 && g->vertices[i]->distance == distances[i]);
+    }
+  mu_assert ("error, dense engine does not match prim",
+             mst_run (g, g->vertices[4], MST_DENSE) == expected
+             && mst_run (g, g->vertices[4], MST_AUTO) == expected);
+
+  // Matrix of the lightest edge between every pair
+  int *matrix = calloc (g->size * g->size, sizeof (int));
+  for (size_t i = 0; i < g->size * g->size; ++i)
+    {
+      matrix[i] = INT_MAX;
+    }
+  for (size_t i = 0; i < g->size; ++i)
+    {
+      graph_vertex *u = g->vertices[i];
+      for (size_t j = 0; j < u->degree; ++j)
+        {
+          int *cell = &matrix[u->id * g->size + u->neighbors[j]->id];
+          *cell = u->weights[j] < *cell ? u->weights[j] : *cell;
+        }
+    }
+  size_t *parent = calloc (g->size, sizeof (size_t));
+  mu_assert ("error, matrix weight does not match prim",
+             mst_prim_matrix (matrix, g->size, 4, parent) == expected);
+  for (size_t i = 0; i < g->size; ++i)
+    {
+      mu_assert ("error, matrix parent does not match prim",
+                 parent[i] ==
+                 (parents[i] != NULL ? parents[i]->id : GRAPH_NONE));
+    }
+
+  free (parent);
+  free (matrix);
+  free (parents);
+  free (distances);
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_mst_prim_dense_extreme ()
+{
+  graph_edge path[] = { {0, 1, INT_MAX}, {1, 2, 5} };
+  graph_edge low[] = { {0, 1, INT_MIN}, {1, 2, 5}, {0, 2, 7} };
+  graph_edge long_path[11];
+  const graph_edge *lists[] = { path, low, long_path };
+  size_t sizes[] = { 3, 3, 12 };
+  size_t counts[] = { 2, 3, 11 };
+
+  // Enough vertices for the vector scan, extreme weights mixed in
+  for (size_t i = 0; i < 11; ++i)
+    {
+      long_path[i].source = (i * 5) % 12;
+      long_path[i].destination = ((i + 1) * 5) % 12;
+      long_path[i].weight = i % 3 == 0 ? INT_MAX : i % 3 == 1 ? INT_MIN : 1;
+    }
+
+  for (size_t k = 0; k < 3; ++k)
+    {
+      graph g;
+      graph_create (&g);
+      graph_build (&g, sizes[k], lists[k], counts[k]);
+      int64_t expected = mst_prim (&g, g.vertices[0]);
+      mu_assert ("error, prim weight of the INT_MAX path is wrong",
+                 k != 0 || expected == (int64_t) INT_MAX + 5);
+      mu_assert ("error, dense weight differs on extreme weights",
+                 mst_prim_dense (&g, g.vertices[0]) == expected
+                 && mst_run (&g, g.vertices[0], MST_DENSE) == expected
+                 && mst_run (&g, g.vertices[0], MST_AUTO) == expected);
+      for (size_t i = 1; i < g.size; ++i)
+        {
+          mu_assert ("error, dense tree misses a vertex",
+                     g.vertices[i]->parent != NULL);
+        }
+      graph_destroy (&g);
+    }
+
+  // INT_MIN is a weight in a matrix, INT_MAX is no edge
+  int matrix[] = { 0, INT_MIN, INT_MAX, INT_MIN, 0, 4, INT_MAX, 4, 0 };
+  size_t parent[3];
+  mu_assert ("error, matrix weight with INT_MIN is wrong",
+             mst_prim_matrix (matrix, 3, 0, parent)
+             == (int64_t) INT_MIN + 4 && parent[2] == 1);
+  return NULL;
+}
+
+static int line_distance (size_t source, size_t destination, void *data)
+{
+  const int *positions = data;
+  int distance = positions[source] - positions[destination];
+  return distance < 0 ? -distance : distance;
+}
+
+static char *test_mst_prim_distance ()
+{
+  int positions[101];
+  size_t parent[101];
+  graph g;
+
+  // Points of a line in shuffled order, the MST links consecutive points
+  for (size_t i = 0; i < 101; ++i)
+    {
+      positions[i] = (int) ((i * 37) % 101);
+    }
+  mu_assert ("error, line weight is wrong",
+             mst_prim_distance (101, 3, line_distance, positions, parent)
+             == 100);
+  for (size_t i = 0; i < 101; ++i)
+    {
+      mu_assert ("error, line parent is not a neighbor point", i == 3
+                 || line_distance (i, parent[i], positions) == 1);
+    }
+
+  // Only the component of the source is spanned
+  graph_create (&g);
+  graph_vertex *a = graph_add_vertex (&g);
+  graph_vertex *b = graph_add_vertex (&g);
+  graph_vertex *c = graph_add_vertex (&g);
+  graph_add_edge (a, b, 3);
+  mu_assert ("error, dense weight of a component is wrong",
+             mst_prim_dense (&g, b) == 3 && a->parent == b
+             && c->parent == NULL && b->parent == NULL);
+  graph_destroy (&g);
+  return NULL;
+}
+
+typedef struct
+{
+  const double *points;
+  size_t dimension;
+} point_set;
+
+static int point_distance (size_t source, size_t destination, void *data)
+{
+  const point_set *set = data;
+  double distance = 0;
+  for (size_t d = 0; d < set->dimension; ++d)
+    {
+      double gap = set->points[source * set->dimension + d]
+        - set->points[destination * set->dimension + d];
+      distance += gap * gap;
+    }
+  return (int) distance;
+}
+
+static char *test_mst_euclidean ()
+{
+  size_t count = 600;
+  double *points = calloc (3 * count, sizeof (double));
+  size_t *parent = calloc (count, sizeof (size_t));
+  size_t *expected = calloc (count, sizeof (size_t));
+  unsigned long seed = 21;
+
+  // Integer coordinates with many ties, squared distances give the same
+  // tree as the distances
+  for (size_t dimension = 2; dimension <= 3; ++dimension)
+    {
+      for (size_t i = 0; i < dimension * count; ++i)
+        {
+          seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+          points[i] = (double) ((seed >> 33) % (dimension == 2 ? 60 : 400));
+        }
+      point_set set = { points, dimension };
+      mst_prim_distance (count, 0, point_distance, &set, expected);
+      double length = 0;
+      for (size_t i = 1; i < count; ++i)
+        {
+          length += sqrt (point_distance (i, expected[i], &set));
+        }
+
+      double total = mst_euclidean (points, count, dimension, parent);
+      mu_assert ("error, euclidean length does not match dense prim",
+                 fabs (total - length) < 1e-6 * length);
+      double tree = 0;
+      for (size_t i = 0; i < count; ++i)
+        {
+          mu_assert ("error, euclidean root is not the first point",
+                     (i == 0) == (parent[i] == GRAPH_NONE));
+          if (i != 0)
+            {
+              tree += sqrt (point_distance (i, parent[i], &set));
+            }
+        }
+      mu_assert ("error, euclidean parents do not match the length",
+                 fabs (tree - total) < 1e-6 * total);
+    }
+
+  mu_assert ("error, single point has a length",
+             mst_euclidean (points, 1, 2, parent) == 0
+             && parent[0] == GRAPH_NONE);
+
+  free (points);
+  free (parent);
+  free (expected);
+  return NULL;
+}
+
+static char *test_mst_stats ()
+{
+  graph *g = calloc (1, sizeof (graph));
+
+  graph_create (g);
+  random_graph (g, 100, 300, 13);
+  mst_stats_reset ();
+  mst_prim (g, g->vertices[0]);
+  mst_stats stats = mst_stats_read ();
+
+#ifdef MST_STATS
+  size_t degrees = 0;
+  for (size_t i = 0; i < g->size; ++i)
+    {
+      degrees += g->vertices[i]->degree;
+    }
+  mu_assert ("error, every vertex is not inserted and extracted once",
+             stats.inserts == g->size && stats.extractions == g->size);
+  mu_assert ("error, every edge is not scanned twice",
+             stats.edges_scanned == degrees);
+  mu_assert ("error, relaxations do not match the queue operations",
+             stats.relaxations + 1 == stats.inserts + stats.decrease_keys);
+  mu_assert ("error, heap has no levels", stats.sift_down_levels != 0);
+  mu_assert ("error, phases are not timed",
+             stats.phases[MST_PHASE_LOOP] > 0);
+
+  // Only keys that go down are counted
+  queue q;
+  queue_create (&q);
+  queue_insert (&q, g->vertices[0], 5);
+  mst_stats_reset ();
+  queue_decrease_key (&q, 0, 7);
+  queue_decrease_key (&q, 0, 5);
+  queue_decrease_key (&q, 1, 1);
+  mu_assert ("error, rejected decrease keys are counted",
+             mst_stats_read ().decrease_keys == 0);
+  queue_decrease_key (&q, 0, 3);
+  mu_assert ("error, decrease key is not counted",
+             mst_stats_read ().decrease_keys == 1);
+  queue_destroy (&q);
+#else
+  mu_assert ("error, counters without MST_STATS",
+             stats.inserts == 0 && stats.edges_scanned == 0
+             && stats.phases[MST_PHASE_LOOP] == 0);
+#endif
+
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_graph_csr_reorder ()
+{
+  graph *g = calloc (1, sizeof (graph));
+  graph_csr csr;
+  graph_csr permuted;
+  graph_order kinds[] = { GRAPH_ORDER_BFS, GRAPH_ORDER_RCM,
+    GRAPH_ORDER_DEGREE
+  };
+
+  graph_create (g);
+  random_graph (g, 300, 900, 14);
+  graph_csr_create (&csr, g);
+  size_t *expected = calloc (g->size, sizeof (size_t));
+  int64_t total = mst_prim_csr (&csr, 9, expected);
+  size_t *order = calloc (g->size, sizeof (size_t));
+  size_t *inverse = calloc (g->size, sizeof (size_t));
+  size_t *parent = calloc (g->size, sizeof (size_t));
+
+  for (size_t k = 0; k < 3; ++k)
+    {
+      graph_csr_order (&csr, kinds[k], order);
+      for (size_t i = 0; i < g->size; ++i)
+        {
+          inverse[i] = GRAPH_NONE;
+        }
+      for (size_t i = 0; i < g->size; ++i)
+        {
+          mu_assert ("error, order is not a permutation",
+                     inverse[order[i]] == GRAPH_NONE);
+          inverse[order[i]] = i;
+        }
+
+      graph_csr_permute (&permuted, &csr, order);
+      mu_assert ("error, reordered weight does not match",
+                 mst_prim_csr (&permuted, inverse[9], parent) == total);
+      for (size_t i = 0; i < g->size; ++i)
+        {
+          size_t original = parent[inverse[i]] == GRAPH_NONE
+            ? GRAPH_NONE : order[parent[inverse[i]]];
+          mu_assert ("error, mapped parent does not match",
+                     original == expected[i]);
+        }
+      for (size_t i = 0; i < g->size; ++i)
+        {
+          for (size_t j = permuted.offsets[i] + 1; j < permuted.offsets[i + 1];
+               ++j)
+            {
+              mu_assert ("error, neighbors are not sorted",
+                         permuted.targets[j - 1] <= permuted.targets[j]);
+            }
+        }
+      graph_csr_destroy (&permuted);
+    }
+
+  graph reordered;
+  graph_reorder (&reordered, g, GRAPH_ORDER_RCM, order);
+  mu_assert ("error, reordered graph weight does not match",
+             mst_prim (&reordered, reordered.vertices[0])
+             == mst_prim (g, g->vertices[order[0]]));
+  for (size_t i = 0; i < g->size; ++i)
+    {
+      mu_assert ("error, reordered degree does not match",
+                 reordered.vertices[i]->degree ==
+                 g->vertices[order[i]]->degree);
+    }
+  graph_destroy (&reordered);
+
+  free (order);
+  free (inverse);
+  free (parent);
+  free (expected);
+  graph_csr_destroy (&csr);
+  graph_destroy (g);
+  free (g);
+  return NULL;
+}
+
+static char *test_graph_csr_order_path ()
+{
+  graph_edge edges[99];
+  graph_csr csr;
+  size_t order[100];
+  size_t inverse[100];
+
+  // A path with shuffled labels gets bandwidth 1 back
+  for (size_t i = 0; i < 99; ++i)
+    {
+      edges[i].source = (i * 37) % 100;
+      edges[i].destination = ((i + 1) * 37) % 100;
+      edges[i].weight = 1;
+    }
+  graph g;
+  graph_create (&g);
+  graph_build (&g, 100, edges, 99);
+  graph_csr_create (&csr, &g);
+  graph_csr_order (&csr, GRAPH_ORDER_RCM, order);
+  for (size_t i = 0; i < 100; ++i)
+    {
+      inverse[order[i]] = i;
+    }
+  for (size_t i = 0; i < 99; ++i)
+    {
+      size_t u = inverse[edges[i].source];
+      size_t v = inverse[edges[i].destination];
+      mu_assert ("error, path bandwidth is not 1", u + 1 == v || v + 1 == u);
+    }
+
+  graph_csr_destroy (&csr);
+  graph_destroy (&g);
+  return NULL;
+}
+
 char *(*tests_functions[]) () = {
   test_mst_dummy,
   test_graph_destroy_null,
@@ -675,6 +2519,15 @@ char *(*tests_functions[]) () = {
   test_graph_add_edge_already_present,
   test_graph_add_edge_large,
   test_graph_add_edge_both_sides_correct,
+  test_graph_build_matches_add_edge,
+  test_graph_build_append,
+  test_graph_build_parallel_matches_build,
+  test_graph_load_edges_snap,
+  test_graph_load_edges_dimacs,
+  test_graph_load_edges_malformed,
+  test_arena_alloc_zeroed,
+  test_graph_arena_prim,
+  test_queue_arena,
   test_queue_size_null,
   test_queue_size_small,
   test_queue_size_large,
@@ -695,8 +2548,46 @@ char *(*tests_functions[]) () = {
   test_queue_insert_ordered,
   test_queue_insert_heapsort_needed,
   test_queue_insert_identical_weight,
+  test_queue_contains,
+  test_queue_dary_heapsort,
+  test_mst_prim_queue_dary,
+  test_queue_pairing_heapsort,
+  test_mst_prim_queue_pairing,
+  test_queue_bucket_heapsort,
+  test_queue_bucket_negative,
+  test_mst_prim_queue_bucket,
   test_mst_prim_null_source,
-  test_mst_prim_single_path
+  test_mst_prim_single_path,
+  test_graph_csr_create,
+  test_mst_prim_csr_matches_prim,
+  test_graph_csr_isolated,
+  test_graph_csr_save_load,
+  test_mst_prim_csr_typed_matches_prim,
+  test_mst_prim_csr_typed_wide,
+  test_graph_csr_load_invalid,
+  test_mst_kruskal_matches_prim,
+  test_mst_kruskal_null_source,
+  test_mst_boruvka_matches_prim,
+  test_mst_boruvka_disconnected,
+  test_mst_prim_disconnected,
+  test_mst_prim_wide_total,
+  test_mst_prim_forest,
+  test_mst_dynamic_insert,
+  test_mst_dynamic_link,
+  test_graph_remove_edge,
+  test_mst_dynamic_remove,
+  test_mst_dynamic_loop,
+  test_mst_batch,
+  test_mst_prim_workspace,
+  test_mst_prim_filter_threads,
+  test_mst_prim_csr_hubs,
+  test_mst_prim_dense,
+  test_mst_prim_dense_extreme,
+  test_mst_prim_distance,
+  test_mst_euclidean,
+  test_mst_stats,
+  test_graph_csr_reorder,
+  test_graph_csr_order_path
 };
 
 int main (int argc, const char *argv[])
@@ -0,0 +1,277 @@
+/*
+ * Typed weight implementation template, included by mst.c once per weight
+ * type with the following macros defined:
+ *   WEIGHT_TYPE   type of the weights
+ *   WEIGHT_NAME   suffix of the generated CSR names, no CSR graph without it
+ *   WEIGHT_HEAP   name of the generated indexed heap, no heap without it
+ * and when both WEIGHT_NAME and WEIGHT_HEAP are defined, for Prim's
+ * algorithm:
+ *   WEIGHT_TOTAL  type of the accumulated total
+ *   WEIGHT_MAX    key of undiscovered vertices
+ *   WEIGHT_MIN    key of vertices already in the tree
+ */
+
+#define WEIGHT_CONCAT_(a, b) a ## b
+#define WEIGHT_CONCAT(a, b) WEIGHT_CONCAT_ (a, b)
+
+#ifdef WEIGHT_HEAP
+
+#define WEIGHT_HEAP_FUNCTION(name) WEIGHT_CONCAT (WEIGHT_HEAP, name)
+
+typedef struct
+{
+  size_t size;
+  size_t *vertices;
+  WEIGHT_TYPE *priorities;      // priorities of the heap slots
+  size_t *positions;            // GRAPH_NONE when not in the heap
+  WEIGHT_TYPE *keys;            // priorities indexed by vertex id
+} WEIGHT_HEAP;
+
+static void WEIGHT_HEAP_FUNCTION (_sift_up) (WEIGHT_HEAP * self, size_t i,
+                                             size_t vertex, WEIGHT_TYPE key)
+{
+  while (i > 0 && self->priorities[(i - 1) / 2] > key)
+    {
+      size_t parent = (i - 1) / 2;
+      self->vertices[i] = self->vertices[parent];
+      self->priorities[i] = self->priorities[parent];
+      self->positions[self->vertices[i]] = i;
+      i = parent;
+    }
+  self->vertices[i] = vertex;
+  self->priorities[i] = key;
+  self->positions[vertex] = i;
+}
+
+static void WEIGHT_HEAP_FUNCTION (_sift_down) (WEIGHT_HEAP * self, size_t i,
+                                               size_t vertex,
+                                               WEIGHT_TYPE key)
+{
+  for (;;)
+    {
+      size_t min = 2 * i + 1;
+      if (min >= self->size)
+        {
+          break;
+        }
+      if (min + 1 < self->size
+          && self->priorities[min + 1] < self->priorities[min])
+        {
+          ++min;
+        }
+      if (self->priorities[min] >= key)
+        {
+          break;
+        }
+      self->vertices[i] = self->vertices[min];
+      self->priorities[i] = self->priorities[min];
+      self->positions[self->vertices[i]] = i;
+      i = min;
+    }
+  self->vertices[i] = vertex;
+  self->priorities[i] = key;
+  self->positions[vertex] = i;
+}
+
+/*
+ * Insert a vertex or decrease its priority to keys[vertex]
+ */
+static void WEIGHT_HEAP_FUNCTION (_update) (WEIGHT_HEAP * self, size_t vertex)
+{
+  size_t i = self->positions[vertex];
+  if (i == GRAPH_NONE)
+    {
+      i = self->size++;
+    }
+  WEIGHT_HEAP_FUNCTION (_sift_up) (self, i, vertex, self->keys[vertex]);
+}
+
+static size_t WEIGHT_HEAP_FUNCTION (_pop) (WEIGHT_HEAP * self)
+{
+  size_t min = self->vertices[0];
+  --self->size;
+  if (self->size != 0)
+    {
+      WEIGHT_HEAP_FUNCTION (_sift_down) (self, 0, self->vertices[self->size],
+                                         self->priorities[self->size]);
+    }
+  self->positions[min] = GRAPH_NONE;
+  return min;
+}
+
+#endif // WEIGHT_HEAP
+
+#ifdef WEIGHT_NAME
+
+#define WEIGHT_GRAPH WEIGHT_CONCAT (graph_csr_, WEIGHT_NAME)
+#define WEIGHT_EDGE WEIGHT_CONCAT (graph_edge_, WEIGHT_NAME)
+#define WEIGHT_FUNCTION(name) WEIGHT_CONCAT (WEIGHT_GRAPH, name)
+
+void WEIGHT_FUNCTION (_create) (WEIGHT_GRAPH * self, const graph * source)
+{
+  if (self == NULL || source == NULL)
+    {
+      return;
+    }
+
+  self->size = source->size;
+  self->offsets = calloc (source->size + 1, sizeof (size_t));
+  for (size_t i = 0; i < source->size; ++i)
+    {
+      self->offsets[i + 1] = self->offsets[i] + source->vertices[i]->degree;
+    }
+
+  size_t edges = self->offsets[source->size];
+  self->targets = calloc (edges + 1, sizeof (size_t));
+  self->weights = calloc (edges + 1, sizeof (WEIGHT_TYPE));
+  for (size_t i = 0; i < source->size; ++i)
+    {
+      graph_vertex *vertex = source->vertices[i];
+      size_t offset = self->offsets[i];
+      for (size_t j = 0; j < vertex->degree; ++j)
+        {
+          self->targets[offset + j] = vertex->neighbors[j]->id;
+          self->weights[offset + j] = (WEIGHT_TYPE) vertex->weights[j];
+        }
+    }
+}
+
+void WEIGHT_FUNCTION (_build) (WEIGHT_GRAPH * self, size_t size,
+                               const WEIGHT_EDGE * edges, size_t count)
+{
+  if (self == NULL || (edges == NULL && count != 0))
+    {
+      return;
+    }
+
+  self->size = size;
+  self->offsets = calloc (size + 1, sizeof (size_t));
+  for (size_t i = 0; i < count; ++i)
+    {
+      if (edges[i].source < size && edges[i].destination < size)
+        {
+          self->offsets[edges[i].source + 1]++;
+          self->offsets[edges[i].destination + 1]++;
+        }
+    }
+  for (size_t i = 0; i < size; ++i)
+    {
+      self->offsets[i + 1] += self->offsets[i];
+    }
+
+  // Fill in edge order, like graph_build
+  size_t *fill = calloc (size + 1, sizeof (size_t));
+  memcpy (fill, self->offsets, size * sizeof (size_t));
+  self->targets = calloc (self->offsets[size] + 1, sizeof (size_t));
+  self->weights = calloc (self->offsets[size] + 1, sizeof (WEIGHT_TYPE));
+  for (size_t i = 0; i < count; ++i)
+    {
+      if (edges[i].source < size && edges[i].destination < size)
+        {
+          size_t slot = fill[edges[i].source]++;
+          self->targets[slot] = edges[i].destination;
+          self->weights[slot] = edges[i].weight;
+          slot = fill[edges[i].destination]++;
+          self->targets[slot] = edges[i].source;
+          self->weights[slot] = edges[i].weight;
+        }
+    }
+  free (fill);
+}
+
+void WEIGHT_FUNCTION (_destroy) (WEIGHT_GRAPH * self)
+{
+  if (self == NULL)
+    {
+      return;
+    }
+
+  free (self->offsets);
+  free (self->targets);
+  free (self->weights);
+  self->offsets = NULL;
+  self->targets = NULL;
+  self->weights = NULL;
+  self->size = 0;
+}
+
+#ifdef WEIGHT_HEAP
+
+WEIGHT_TOTAL WEIGHT_CONCAT (mst_prim_csr_, WEIGHT_NAME) (const WEIGHT_GRAPH *
+                                                         self, size_t source,
+                                                         size_t * parent)
+{
+  if (self == NULL || source >= self->size)
+    {
+      return 0;
+    }
+
+  size_t *parents = parent;
+  if (parents == NULL)
+    {
+      parents = calloc (self->size, sizeof (size_t));
+    }
+
+  WEIGHT_HEAP heap;
+  heap.size = 0;
+  heap.vertices = calloc (self->size, sizeof (size_t));
+  heap.priorities = calloc (self->size, sizeof (WEIGHT_TYPE));
+  heap.positions = calloc (self->size, sizeof (size_t));
+  heap.keys = calloc (self->size, sizeof (WEIGHT_TYPE));
+  for (size_t i = 0; i < self->size; ++i)
+    {
+      heap.keys[i] = WEIGHT_MAX;
+      heap.positions[i] = GRAPH_NONE;
+      parents[i] = GRAPH_NONE;
+    }
+  heap.keys[source] = 0;
+  WEIGHT_HEAP_FUNCTION (_update) (&heap, source);
+
+  WEIGHT_TOTAL total = 0;
+  while (heap.size != 0)
+    {
+      size_t u = WEIGHT_HEAP_FUNCTION (_pop) (&heap);
+      total += (WEIGHT_TOTAL) heap.keys[u];
+      heap.keys[u] = WEIGHT_MIN;
+
+      for (size_t i = self->offsets[u]; i < self->offsets[u + 1]; ++i)
+        {
+          size_t v = self->targets[i];
+          WEIGHT_TYPE weight = self->weights[i];
+          if (weight <= heap.keys[v] && heap.keys[v] != WEIGHT_MIN)
+            {
+              parents[v] = u;
+              heap.keys[v] = weight;
+              WEIGHT_HEAP_FUNCTION (_update) (&heap, v);
+            }
+        }
+    }
+
+  free (heap.vertices);
+  free (heap.priorities);
+  free (heap.positions);
+  free (heap.keys);
+  if (parent == NULL)
+    {
+      free (parents);
+    }
+  return total;
+}
+
+#endif // WEIGHT_HEAP
+
+#undef WEIGHT_FUNCTION
+#undef WEIGHT_EDGE
+#undef WEIGHT_GRAPH
+
+#endif // WEIGHT_NAME
+
+#undef WEIGHT_HEAP_FUNCTION
+#undef WEIGHT_HEAP
+#undef WEIGHT_CONCAT
+#undef WEIGHT_CONCAT_
+#undef WEIGHT_NAME
+#undef WEIGHT_TYPE
+#undef WEIGHT_TOTAL
+#undef WEIGHT_MAX
+#undef WEIGHT_MIN